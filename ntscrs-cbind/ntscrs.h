@@ -79,6 +79,34 @@ typedef enum NtscRsUseField {
   UseFieldBoth,
 } NtscRsUseField;
 
+/**
+ * An effect prepared from a parameter set once, for applying it to many
+ * frames without converting the parameters again each time.
+ */
+typedef struct NtscRsEffect NtscRsEffect;
+
+/**
+ * A private worker pool, for benchmarking a thread count without changing the
+ * one used by ntscrs_apply_effect_to_buffer.
+ */
+typedef struct NtscRsThreadPool NtscRsThreadPool;
+
+/**
+ * Called on each effect worker thread as it starts, with its index.
+ */
+typedef void (*NtscRsWorkerStartFn)(uintptr_t index);
+
+/**
+ * Heap memory held by the effect, in bytes.
+ */
+typedef struct NtscRsMemoryStats {
+  uintptr_t current;
+  /**
+   * highest `current` since the library was loaded
+   */
+  uintptr_t peak;
+} NtscRsMemoryStats;
+
 typedef struct NtscRsHeadSwitchingSettings {
   uint32_t height;
   uint32_t offset;
@@ -165,6 +193,19 @@ typedef struct NtscRsEffectParams {
 
 void ntscrs_default_effect_params(struct NtscRsEffectParams *params);
 
+/**
+ * Turns off stages whose settings make them leave the frame unchanged, so the
+ * effect skips them entirely. Output is unaffected. Returns how many stages
+ * were turned off.
+ */
+uint32_t ntscrs_plan_params(struct NtscRsEffectParams *params);
+
+/**
+ * Hashes the settings the effect actually uses, so values kept around for
+ * disabled stages don't make otherwise identical parameter sets differ.
+ */
+uint64_t ntscrs_params_hash(struct NtscRsEffectParams params);
+
 void ntscrs_apply_effect_to_buffer_rgbx8(struct NtscRsEffectParams params,
                                          uintptr_t dimension_x,
                                          uintptr_t dimension_y,
@@ -315,3 +356,82 @@ void ntscrs_apply_effect_to_buffer(struct NtscRsEffectParams params,
                                    uint8_t *input_frame,
                                    enum NtscRsPixelFormat pix_fmt,
                                    uintptr_t frame_num);
+
+/**
+ * Like `ntscrs_apply_effect_to_buffer`, but runs the effect at half horizontal
+ * resolution for 8-bit, 4-channel formats (see draft.rs). Other formats are
+ * processed at full quality.
+ */
+void ntscrs_apply_effect_to_buffer_draft(struct NtscRsEffectParams params,
+                                         uintptr_t dimension_x,
+                                         uintptr_t dimension_y,
+                                         uint8_t *input_frame,
+                                         enum NtscRsPixelFormat pix_fmt,
+                                         uintptr_t frame_num);
+
+struct NtscRsEffect *ntscrs_effect_create(struct NtscRsEffectParams params);
+
+/**
+ * Does nothing for NULL.
+ */
+void ntscrs_effect_free(struct NtscRsEffect *effect);
+
+/**
+ * `ntscrs_apply_effect_to_buffer` with a prepared effect. The effect is only
+ * read, so several threads may apply the same one at once.
+ */
+void ntscrs_effect_apply(const struct NtscRsEffect *effect,
+                         uintptr_t dimension_x,
+                         uintptr_t dimension_y,
+                         uint8_t *input_frame,
+                         enum NtscRsPixelFormat pix_fmt,
+                         uintptr_t frame_num);
+
+/**
+ * `ntscrs_apply_effect_to_buffer_draft` with a prepared effect.
+ */
+void ntscrs_effect_apply_draft(const struct NtscRsEffect *effect,
+                               uintptr_t dimension_x,
+                               uintptr_t dimension_y,
+                               uint8_t *input_frame,
+                               enum NtscRsPixelFormat pix_fmt,
+                               uintptr_t frame_num);
+
+/**
+ * Runs the effect on a pool of `threads` workers from now on; 0 returns to
+ * the default pool sized to the machine. Frames already in progress finish
+ * on the previous pool. Returns false if the pool couldn't be created.
+ */
+bool ntscrs_set_thread_count(uintptr_t threads);
+
+/**
+ * Recreates the effect's pool so that every worker runs `handler` first;
+ * NULL removes it. Benchmark pools from ntscrs_thread_pool_create don't run
+ * it. Returns false if the pool couldn't be created.
+ */
+bool ntscrs_set_worker_start_handler(NtscRsWorkerStartFn handler);
+
+/**
+ * Number of worker threads the effect is currently spread over.
+ */
+uintptr_t ntscrs_thread_count(void);
+
+/**
+ * Returns NULL if the pool couldn't be created.
+ */
+struct NtscRsThreadPool *ntscrs_thread_pool_create(uintptr_t threads);
+
+void ntscrs_thread_pool_free(struct NtscRsThreadPool *pool);
+
+/**
+ * `ntscrs_apply_effect_to_buffer` on the given pool.
+ */
+void ntscrs_thread_pool_apply_effect_to_buffer(const struct NtscRsThreadPool *pool,
+                                               struct NtscRsEffectParams params,
+                                               uintptr_t dimension_x,
+                                               uintptr_t dimension_y,
+                                               uint8_t *input_frame,
+                                               enum NtscRsPixelFormat pix_fmt,
+                                               uintptr_t frame_num);
+
+struct NtscRsMemoryStats ntscrs_memory_stats(void);
@@ -0,0 +1,69 @@
+// Reduced-cost "draft" processing for 8-bit, 4-channel frames.
+//
+// The effect itself always works in f32 YIQ. Draft mode instead narrows what it
+// has to work on: the frame is averaged down to half width in integer
+// arithmetic, the effect runs on that with a matching horizontal scale factor,
+// and the result is interpolated back up. This halves the effect's working
+// set and per-row work at the cost of horizontal detail, so it is meant for
+// previews where bit-exactness doesn't matter.
+
+use ntscrs::yiq_fielding::PixelFormat;
+
+use crate::fields::Prepared;
+
+const CHANNELS: usize = 4;
+
+fn downsample_row(src: &[u8], dst: &mut [u8]) {
+    let pairs = src.len() / (2 * CHANNELS);
+    for (d, s) in dst.chunks_exact_mut(CHANNELS).zip(src.chunks_exact(2 * CHANNELS)) {
+        for c in 0..CHANNELS {
+            d[c] = ((s[c] as u16 + s[c + CHANNELS] as u16 + 1) >> 1) as u8;
+        }
+    }
+    // odd width: the last pixel has no partner
+    if src.len() % (2 * CHANNELS) != 0 {
+        let s = &src[pairs * 2 * CHANNELS..];
+        dst[pairs * CHANNELS..(pairs + 1) * CHANNELS].copy_from_slice(&s[..CHANNELS]);
+    }
+}
+
+fn upsample_row(src: &[u8], dst: &mut [u8]) {
+    let src_w = src.len() / CHANNELS;
+    let dst_w = dst.len() / CHANNELS;
+    for x in 0..dst_w {
+        let i = x / 2;
+        let j = if x % 2 == 1 && i + 1 < src_w { i + 1 } else { i };
+        for c in 0..CHANNELS {
+            let a = src[i * CHANNELS + c] as u16;
+            let b = src[j * CHANNELS + c] as u16;
+            dst[x * CHANNELS + c] = ((a + b + 1) >> 1) as u8;
+        }
+    }
+}
+
+pub fn apply_draft<S: PixelFormat<DataFormat = u8>>(
+    effect: &Prepared,
+    (width, height): (usize, usize),
+    frame: &mut [u8],
+    frame_num: usize,
+) {
+    let half_width = (width + 1) / 2;
+    let row = width * CHANNELS;
+    let half_row = half_width * CHANNELS;
+
+    let mut half = vec![0u8; half_row * height];
+    for (src, dst) in frame.chunks_exact(row).zip(half.chunks_exact_mut(half_row)) {
+        downsample_row(src, dst);
+    }
+
+    effect.apply_effect_to_buffer::<S>(
+        (half_width, height),
+        &mut half,
+        frame_num,
+        [half_width as f32 / width as f32, 1.0],
+    );
+
+    for (src, dst) in half.chunks_exact(half_row).zip(frame.chunks_exact_mut(row)) {
+        upsample_row(src, dst);
+    }
+}
@@ -0,0 +1,104 @@
+// Field-level parallelism for the interleaved field modes.
+//
+// With UseField::InterleavedUpper/Lower, ntsc-rs treats the two fields of a
+// frame as consecutive frames of half the height (frame numbers 2n and 2n + 1,
+// the first field in time getting 2n) and runs the whole effect on one, then
+// the other, spreading each pass over the pool row by row. The fields don't
+// depend on each other until they are woven back together, so here they run
+// as two tasks side by side instead: each is the same effect restricted to
+// one field (UseField::Upper or Lower) on its own copy of the frame, and the
+// lower field's rows are copied back at the end. Each task keeps its own
+// half-height working set, and the pool gets two large independent jobs to
+// balance rather than one pass whose rows run out before the cores do.
+//
+// The output is meant to be identical to processing both fields in one pass;
+// ntscrs-golden verify checks that with its "interleaved" preset.
+
+use ntscrs::{ntsc::NtscEffect, settings::standard::UseField, yiq_fielding::PixelFormat};
+
+struct Fields {
+    upper: NtscEffect,
+    lower: NtscEffect,
+    upper_first: bool,
+}
+
+/// An effect ready to be applied, including the per-field effects for the
+/// interleaved modes.
+pub struct Prepared {
+    pub effect: NtscEffect,
+    fields: Option<Fields>,
+}
+
+impl Prepared {
+    pub fn new(effect: NtscEffect) -> Self {
+        let upper_first = match effect.use_field {
+            UseField::InterleavedUpper => Some(true),
+            UseField::InterleavedLower => Some(false),
+            _ => None,
+        };
+        let single = |field| {
+            let mut e = effect.clone();
+            e.use_field = field;
+            e
+        };
+        let fields = upper_first.map(|upper_first| Fields {
+            upper: single(UseField::Upper),
+            lower: single(UseField::Lower),
+            upper_first,
+        });
+        Prepared { effect, fields }
+    }
+
+    /// Same as NtscEffect::apply_effect_to_buffer. Has to run on the pool the
+    /// fields should share, see pool::run.
+    pub fn apply_effect_to_buffer<S: PixelFormat>(
+        &self,
+        (width, height): (usize, usize),
+        frame: &mut [S::DataFormat],
+        frame_num: usize,
+        scale: [f32; 2],
+    ) where
+        S::DataFormat: Copy + Send + Sync,
+    {
+        match &self.fields {
+            // on one thread the split only adds the copies
+            Some(fields) if height > 1 && rayon::current_num_threads() > 1 => {
+                fields.apply::<S>((width, height), frame, frame_num, scale)
+            }
+            _ => self.effect.apply_effect_to_buffer::<S>((width, height), frame, frame_num, scale),
+        }
+    }
+}
+
+impl Fields {
+    fn apply<S: PixelFormat>(
+        &self,
+        (width, height): (usize, usize),
+        frame: &mut [S::DataFormat],
+        frame_num: usize,
+        scale: [f32; 2],
+    ) where
+        S::DataFormat: Copy + Send + Sync,
+    {
+        let row = width * S::pixel_bytes() / std::mem::size_of::<S::DataFormat>();
+        let frame = &mut frame[..row * height];
+
+        // the lower field's pass reads only the odd rows but writes all of them
+        let mut lower_frame = frame.to_vec();
+        let (upper_num, lower_num) = if self.upper_first {
+            (frame_num * 2, frame_num * 2 + 1)
+        } else {
+            (frame_num * 2 + 1, frame_num * 2)
+        };
+
+        rayon::join(
+            || self.upper.apply_effect_to_buffer::<S>((width, height), frame, upper_num, scale),
+            || self.lower.apply_effect_to_buffer::<S>((width, height), &mut lower_frame, lower_num, scale),
+        );
+
+        // weave: the upper pass left interpolated rows where the lower field goes
+        for (dst, src) in frame.chunks_exact_mut(row).zip(lower_frame.chunks_exact(row)).skip(1).step_by(2) {
+            dst.copy_from_slice(src);
+        }
+    }
+}
@@ -4,6 +4,12 @@ use ntscrs::{
     yiq_fielding::*,
 };
 
+mod alloc;
+mod draft;
+mod fields;
+mod plan;
+mod pool;
+
 #[repr(C)]
 pub enum NtscRsPixelFormat {
     Rgbx8,
@@ -476,6 +482,27 @@ pub extern "C" fn ntscrs_default_effect_params(params: *mut NtscRsEffectParams)
     unsafe { *params = NtscRsEffectParams::default() };
 }
 
+/// Turns off stages whose settings make them leave the frame unchanged, so the
+/// effect skips them entirely. Output is unaffected. Returns how many stages
+/// were turned off.
+#[no_mangle]
+pub extern "C" fn ntscrs_plan_params(params: *mut NtscRsEffectParams) -> u32 {
+    plan::prune(unsafe { &mut *params })
+}
+
+/// Hashes the settings the effect actually uses, so values kept around for
+/// disabled stages don't make otherwise identical parameter sets differ.
+#[no_mangle]
+pub extern "C" fn ntscrs_params_hash(params: NtscRsEffectParams) -> u64 {
+    use std::hash::{Hash, Hasher};
+
+    let effect = ntscrs_effect_from_params(params);
+    let mut hasher = std::collections::hash_map::DefaultHasher::new();
+    // floats don't implement Hash; their Debug output round-trips exactly
+    format!("{:?}", effect).hash(&mut hasher);
+    hasher.finish()
+}
+
 #[macro_export]
 macro_rules! impl_pix_fmt_fn {
     ($fn_name: ident, $pix_fmt: ident) => {
@@ -487,19 +514,34 @@ macro_rules! impl_pix_fmt_fn {
             input_frame: *mut u8,
             frame_num: usize,
         ) {
-            let buf_size = dimension_x * dimension_y * $pix_fmt::pixel_bytes();
-            let input_frame = unsafe { std::slice::from_raw_parts_mut(input_frame as *mut <$pix_fmt as PixelFormat>::DataFormat, buf_size) };
-            let effect = ntscrs_effect_from_params(params);
-            effect.apply_effect_to_buffer::<$pix_fmt>(
-                (dimension_x, dimension_y),
+            apply::<$pix_fmt>(
+                &fields::Prepared::new(ntscrs_effect_from_params(params)),
+                dimension_x,
+                dimension_y,
                 input_frame,
                 frame_num,
-                [1.0, 1.0],
             );
         }
     };
 }
 
+fn apply<S: PixelFormat>(
+    effect: &fields::Prepared,
+    dimension_x: usize,
+    dimension_y: usize,
+    input_frame: *mut u8,
+    frame_num: usize,
+) where
+    S::DataFormat: Copy + Send + Sync,
+{
+    // pixel_bytes is in bytes, the slice is in samples
+    let buf_size = dimension_x * dimension_y * S::pixel_bytes() / std::mem::size_of::<S::DataFormat>();
+    let input_frame = unsafe { std::slice::from_raw_parts_mut(input_frame as *mut S::DataFormat, buf_size) };
+    pool::run(move || {
+        effect.apply_effect_to_buffer::<S>((dimension_x, dimension_y), input_frame, frame_num, [1.0, 1.0])
+    });
+}
+
 impl_pix_fmt_fn!(ntscrs_apply_effect_to_buffer_rgbx8, Rgbx8);
 impl_pix_fmt_fn!(ntscrs_apply_effect_to_buffer_xrgb8, Xrgb8);
 impl_pix_fmt_fn!(ntscrs_apply_effect_to_buffer_bgrx8, Bgrx8);
@@ -533,35 +575,213 @@ pub extern "C" fn ntscrs_apply_effect_to_buffer(
     input_frame: *mut u8,
     pix_fmt: NtscRsPixelFormat,
     frame_num: usize,
+) {
+    let effect = fields::Prepared::new(ntscrs_effect_from_params(params));
+    apply_any(&effect, dimension_x, dimension_y, input_frame, pix_fmt, frame_num)
+}
+
+fn apply_any(
+    effect: &fields::Prepared,
+    dimension_x: usize,
+    dimension_y: usize,
+    input_frame: *mut u8,
+    pix_fmt: NtscRsPixelFormat,
+    frame_num: usize,
 ) {
     macro_rules! call_with_args {
-        ($x: ident) => { $x(params, dimension_x, dimension_y, input_frame, frame_num) };
+        ($x: ident) => { apply::<$x>(effect, dimension_x, dimension_y, input_frame, frame_num) };
     }
 
     match pix_fmt {
-        NtscRsPixelFormat::Rgbx8 => call_with_args!(ntscrs_apply_effect_to_buffer_rgbx8),
-        NtscRsPixelFormat::Xrgb8 => call_with_args!(ntscrs_apply_effect_to_buffer_xrgb8),
-        NtscRsPixelFormat::Bgrx8 => call_with_args!(ntscrs_apply_effect_to_buffer_bgrx8),
-        NtscRsPixelFormat::Xbgr8 => call_with_args!(ntscrs_apply_effect_to_buffer_xbgr8),
-        NtscRsPixelFormat::Rgbx16 => call_with_args!(ntscrs_apply_effect_to_buffer_rgbx16),
-        NtscRsPixelFormat::Xrgb16 => call_with_args!(ntscrs_apply_effect_to_buffer_xrgb16),
-        NtscRsPixelFormat::Bgrx16 => call_with_args!(ntscrs_apply_effect_to_buffer_bgrx16),
-        NtscRsPixelFormat::Xbgr16 => call_with_args!(ntscrs_apply_effect_to_buffer_xbgr16),
-        NtscRsPixelFormat::Rgbx16s => call_with_args!(ntscrs_apply_effect_to_buffer_rgbx16s),
-        NtscRsPixelFormat::Xrgb16s => call_with_args!(ntscrs_apply_effect_to_buffer_xrgb16s),
-        NtscRsPixelFormat::Bgrx16s => call_with_args!(ntscrs_apply_effect_to_buffer_bgrx16s),
-        NtscRsPixelFormat::Xbgr16s => call_with_args!(ntscrs_apply_effect_to_buffer_xbgr16s),
-        NtscRsPixelFormat::Rgbx32f => call_with_args!(ntscrs_apply_effect_to_buffer_rgbx32f),
-        NtscRsPixelFormat::Xrgb32f => call_with_args!(ntscrs_apply_effect_to_buffer_xrgb32f),
-        NtscRsPixelFormat::Bgrx32f => call_with_args!(ntscrs_apply_effect_to_buffer_bgrx32f),
-        NtscRsPixelFormat::Xbgr32f => call_with_args!(ntscrs_apply_effect_to_buffer_xbgr32f),
-        NtscRsPixelFormat::Rgb8 => call_with_args!(ntscrs_apply_effect_to_buffer_rgb8),
-        NtscRsPixelFormat::Bgr8 => call_with_args!(ntscrs_apply_effect_to_buffer_bgr8),
-        NtscRsPixelFormat::Rgb16 => call_with_args!(ntscrs_apply_effect_to_buffer_rgb16),
-        NtscRsPixelFormat::Bgr16 => call_with_args!(ntscrs_apply_effect_to_buffer_bgr16),
-        NtscRsPixelFormat::Rgb16s => call_with_args!(ntscrs_apply_effect_to_buffer_rgb16s),
-        NtscRsPixelFormat::Bgr16s => call_with_args!(ntscrs_apply_effect_to_buffer_bgr16s),
-        NtscRsPixelFormat::Rgb32f => call_with_args!(ntscrs_apply_effect_to_buffer_rgb32f),
-        NtscRsPixelFormat::Bgr32f => call_with_args!(ntscrs_apply_effect_to_buffer_bgr32f),
+        NtscRsPixelFormat::Rgbx8 => call_with_args!(Rgbx8),
+        NtscRsPixelFormat::Xrgb8 => call_with_args!(Xrgb8),
+        NtscRsPixelFormat::Bgrx8 => call_with_args!(Bgrx8),
+        NtscRsPixelFormat::Xbgr8 => call_with_args!(Xbgr8),
+        NtscRsPixelFormat::Rgbx16 => call_with_args!(Rgbx16),
+        NtscRsPixelFormat::Xrgb16 => call_with_args!(Xrgb16),
+        NtscRsPixelFormat::Bgrx16 => call_with_args!(Bgrx16),
+        NtscRsPixelFormat::Xbgr16 => call_with_args!(Xbgr16),
+        NtscRsPixelFormat::Rgbx16s => call_with_args!(Rgbx16s),
+        NtscRsPixelFormat::Xrgb16s => call_with_args!(Xrgb16s),
+        NtscRsPixelFormat::Bgrx16s => call_with_args!(Bgrx16s),
+        NtscRsPixelFormat::Xbgr16s => call_with_args!(Xbgr16s),
+        NtscRsPixelFormat::Rgbx32f => call_with_args!(Rgbx32f),
+        NtscRsPixelFormat::Xrgb32f => call_with_args!(Xrgb32f),
+        NtscRsPixelFormat::Bgrx32f => call_with_args!(Bgrx32f),
+        NtscRsPixelFormat::Xbgr32f => call_with_args!(Xbgr32f),
+        NtscRsPixelFormat::Rgb8 => call_with_args!(Rgb8),
+        NtscRsPixelFormat::Bgr8 => call_with_args!(Bgr8),
+        NtscRsPixelFormat::Rgb16 => call_with_args!(Rgb16),
+        NtscRsPixelFormat::Bgr16 => call_with_args!(Bgr16),
+        NtscRsPixelFormat::Rgb16s => call_with_args!(Rgb16s),
+        NtscRsPixelFormat::Bgr16s => call_with_args!(Bgr16s),
+        NtscRsPixelFormat::Rgb32f => call_with_args!(Rgb32f),
+        NtscRsPixelFormat::Bgr32f => call_with_args!(Bgr32f),
+    }
+}
+
+/// Like `ntscrs_apply_effect_to_buffer`, but runs the effect at half horizontal
+/// resolution for 8-bit, 4-channel formats (see draft.rs). Other formats are
+/// processed at full quality.
+#[no_mangle]
+pub extern "C" fn ntscrs_apply_effect_to_buffer_draft(
+    params: NtscRsEffectParams,
+    dimension_x: usize,
+    dimension_y: usize,
+    input_frame: *mut u8,
+    pix_fmt: NtscRsPixelFormat,
+    frame_num: usize,
+) {
+    let effect = fields::Prepared::new(ntscrs_effect_from_params(params));
+    apply_any_draft(&effect, dimension_x, dimension_y, input_frame, pix_fmt, frame_num)
+}
+
+fn apply_any_draft(
+    effect: &fields::Prepared,
+    dimension_x: usize,
+    dimension_y: usize,
+    input_frame: *mut u8,
+    pix_fmt: NtscRsPixelFormat,
+    frame_num: usize,
+) {
+    macro_rules! draft_with {
+        ($x: ident) => {{
+            let buf = unsafe { std::slice::from_raw_parts_mut(input_frame, dimension_x * dimension_y * 4) };
+            pool::run(move || draft::apply_draft::<$x>(effect, (dimension_x, dimension_y), buf, frame_num))
+        }};
+    }
+
+    match pix_fmt {
+        NtscRsPixelFormat::Rgbx8 => draft_with!(Rgbx8),
+        NtscRsPixelFormat::Xrgb8 => draft_with!(Xrgb8),
+        NtscRsPixelFormat::Bgrx8 => draft_with!(Bgrx8),
+        NtscRsPixelFormat::Xbgr8 => draft_with!(Xbgr8),
+        _ => apply_any(effect, dimension_x, dimension_y, input_frame, pix_fmt, frame_num),
+    }
+}
+
+/// An effect prepared from a parameter set once, for applying it to many
+/// frames without converting the parameters again each time.
+pub struct NtscRsEffect(fields::Prepared);
+
+#[no_mangle]
+pub extern "C" fn ntscrs_effect_create(params: NtscRsEffectParams) -> *mut NtscRsEffect {
+    Box::into_raw(Box::new(NtscRsEffect(fields::Prepared::new(ntscrs_effect_from_params(params)))))
+}
+
+/// Does nothing for NULL.
+#[no_mangle]
+pub extern "C" fn ntscrs_effect_free(effect: *mut NtscRsEffect) {
+    if !effect.is_null() {
+        drop(unsafe { Box::from_raw(effect) });
+    }
+}
+
+/// `ntscrs_apply_effect_to_buffer` with a prepared effect. The effect is only
+/// read, so several threads may apply the same one at once.
+#[no_mangle]
+pub extern "C" fn ntscrs_effect_apply(
+    effect: *const NtscRsEffect,
+    dimension_x: usize,
+    dimension_y: usize,
+    input_frame: *mut u8,
+    pix_fmt: NtscRsPixelFormat,
+    frame_num: usize,
+) {
+    let effect = unsafe { &(*effect).0 };
+    apply_any(effect, dimension_x, dimension_y, input_frame, pix_fmt, frame_num)
+}
+
+/// `ntscrs_apply_effect_to_buffer_draft` with a prepared effect.
+#[no_mangle]
+pub extern "C" fn ntscrs_effect_apply_draft(
+    effect: *const NtscRsEffect,
+    dimension_x: usize,
+    dimension_y: usize,
+    input_frame: *mut u8,
+    pix_fmt: NtscRsPixelFormat,
+    frame_num: usize,
+) {
+    let effect = unsafe { &(*effect).0 };
+    apply_any_draft(effect, dimension_x, dimension_y, input_frame, pix_fmt, frame_num)
+}
+
+/// Runs the effect on a pool of `threads` workers from now on; 0 returns to
+/// the default pool sized to the machine. Frames already in progress finish
+/// on the previous pool. Returns false if the pool couldn't be created.
+#[no_mangle]
+pub extern "C" fn ntscrs_set_thread_count(threads: usize) -> bool {
+    pool::set_active(threads)
+}
+
+/// Called on each effect worker thread as it starts, with its index.
+pub type NtscRsWorkerStartFn = Option<extern "C" fn(index: usize)>;
+
+/// Recreates the effect's pool so that every worker runs `handler` first;
+/// NULL removes it. Benchmark pools from ntscrs_thread_pool_create don't run
+/// it. Returns false if the pool couldn't be created.
+#[no_mangle]
+pub extern "C" fn ntscrs_set_worker_start_handler(handler: NtscRsWorkerStartFn) -> bool {
+    pool::set_start_handler(handler)
+}
+
+/// Number of worker threads the effect is currently spread over.
+#[no_mangle]
+pub extern "C" fn ntscrs_thread_count() -> usize {
+    pool::threads()
+}
+
+/// A private worker pool, for benchmarking a thread count without changing the
+/// one used by ntscrs_apply_effect_to_buffer.
+pub struct NtscRsThreadPool(rayon::ThreadPool);
+
+/// Returns NULL if the pool couldn't be created.
+#[no_mangle]
+pub extern "C" fn ntscrs_thread_pool_create(threads: usize) -> *mut NtscRsThreadPool {
+    match pool::build(threads, None) {
+        Some(pool) => Box::into_raw(Box::new(NtscRsThreadPool(pool))),
+        None => std::ptr::null_mut(),
+    }
+}
+
+#[no_mangle]
+pub extern "C" fn ntscrs_thread_pool_free(pool: *mut NtscRsThreadPool) {
+    if !pool.is_null() {
+        drop(unsafe { Box::from_raw(pool) });
+    }
+}
+
+/// `ntscrs_apply_effect_to_buffer` on the given pool.
+#[no_mangle]
+pub extern "C" fn ntscrs_thread_pool_apply_effect_to_buffer(
+    pool: *const NtscRsThreadPool,
+    params: NtscRsEffectParams,
+    dimension_x: usize,
+    dimension_y: usize,
+    input_frame: *mut u8,
+    pix_fmt: NtscRsPixelFormat,
+    frame_num: usize,
+) {
+    let pool = unsafe { &(*pool).0 };
+    // raw pointers aren't Send; the caller keeps the buffer alive throughout
+    let frame = input_frame as usize;
+    pool.install(move || {
+        ntscrs_apply_effect_to_buffer(params, dimension_x, dimension_y, frame as *mut u8, pix_fmt, frame_num)
+    });
+}
+
+/// Heap memory held by the effect, in bytes.
+#[repr(C)]
+pub struct NtscRsMemoryStats {
+    pub current: usize,
+    /// highest `current` since the library was loaded
+    pub peak: usize,
+}
+
+#[no_mangle]
+pub extern "C" fn ntscrs_memory_stats() -> NtscRsMemoryStats {
+    NtscRsMemoryStats {
+        current: alloc::current(),
+        peak: alloc::peak(),
     }
 }
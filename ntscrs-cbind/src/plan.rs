@@ -0,0 +1,48 @@
+// Stage plan: turns off stages whose settings make them do nothing.
+//
+// ntsc-rs skips a stage entirely when it's disabled, but an enabled stage runs
+// its full per-row and per-pixel loops even when, say, its intensity is 0 and
+// every sample comes out unchanged. Presets and half-finished edits produce
+// that a lot. Planning once per settings change, rather than per frame, also
+// lets the plugin's own checks (incremental eligibility, output sharing) see
+// the reduced set.
+//
+// Only settings that leave the stage's output exactly equal to its input are
+// pruned, so full-quality output stays bit-identical; ntscrs-golden verify
+// checks that against the pinned ntsc-rs revision.
+
+use crate::{NtscRsEffectParams, NtscRsTapeSpeed};
+
+/// Returns the number of stages turned off.
+pub fn prune(p: &mut NtscRsEffectParams) -> u32 {
+    let mut pruned = 0;
+    let mut off = |enabled: &mut bool, no_op: bool| {
+        if *enabled && no_op {
+            *enabled = false;
+            pruned += 1;
+        }
+    };
+
+    // bands of zero rows
+    off(&mut p.enable_head_switching, p.head_switching.height == 0);
+    off(&mut p.enable_tracking_noise, p.tracking_noise.height == 0);
+
+    // these add or blend in their result scaled by the intensity
+    off(&mut p.enable_composite_noise, p.composite_noise.intensity == 0.0);
+    off(&mut p.enable_luma_noise, p.luma_noise.intensity == 0.0);
+    off(&mut p.enable_chroma_noise, p.chroma_noise.intensity == 0.0);
+    off(&mut p.enable_ringing, p.ringing.intensity == 0.0);
+
+    let vhs = &mut p.vhs_settings;
+    if p.enable_vhs {
+        off(&mut vhs.enable_sharpen, vhs.sharpen_intensity == 0.0);
+        off(&mut vhs.enable_edge_wave, vhs.edge_wave_intensity == 0.0);
+    }
+    let vhs_no_op = matches!(vhs.tape_speed, NtscRsTapeSpeed::TapeSpeedNONE)
+        && vhs.chroma_loss == 0.0
+        && !vhs.enable_sharpen
+        && !vhs.enable_edge_wave;
+    off(&mut p.enable_vhs, vhs_no_op);
+
+    pruned
+}
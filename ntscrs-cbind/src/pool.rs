@@ -0,0 +1,83 @@
+// Worker pools the effect runs on.
+//
+// ntsc-rs parallelizes with rayon, which by default uses one global pool sized
+// to the machine. The plugin can replace that with a pool of its own size
+// (ntscrs_set_thread_count) and have every worker run a callback as it starts,
+// e.g. to lower its priority (ntscrs_set_worker_start_handler). Other sizes
+// can be benchmarked on private pools without disturbing frames being
+// rendered at the same time.
+
+use std::sync::{Arc, Mutex, RwLock};
+
+use rayon::{ThreadPool, ThreadPoolBuilder};
+
+pub type StartHandler = extern "C" fn(usize);
+
+struct Config {
+    threads: usize,
+    on_start: Option<StartHandler>,
+}
+
+static CONFIG: Mutex<Config> = Mutex::new(Config { threads: 0, on_start: None });
+static ACTIVE: RwLock<Option<Arc<ThreadPool>>> = RwLock::new(None);
+
+/// 0 threads sizes the pool to the machine, as rayon's global pool is.
+pub fn build(threads: usize, on_start: Option<StartHandler>) -> Option<ThreadPool> {
+    let mut builder = ThreadPoolBuilder::new()
+        .num_threads(threads)
+        .thread_name(|i| format!("ntscrs-worker-{}", i));
+    if let Some(on_start) = on_start {
+        builder = builder.start_handler(move |i| on_start(i));
+    }
+    builder.build().ok()
+}
+
+/// Runs f on the pool set with ntscrs_set_thread_count, or on the caller's
+/// pool if it already is a pool worker (which is how benchmark pools take
+/// precedence over the active one).
+pub fn run<R: Send>(f: impl FnOnce() -> R + Send) -> R {
+    if rayon::current_thread_index().is_some() {
+        return f();
+    }
+    let pool = ACTIVE.read().unwrap_or_else(|e| e.into_inner()).clone();
+    match pool {
+        Some(pool) => pool.install(f),
+        None => f(),
+    }
+}
+
+/// Number of workers run() spreads the effect over.
+pub fn threads() -> usize {
+    match ACTIVE.read().unwrap_or_else(|e| e.into_inner()).as_ref() {
+        Some(pool) => pool.current_num_threads(),
+        None => rayon::current_num_threads(),
+    }
+}
+
+fn rebuild(config: &Config) -> bool {
+    // the global pool is only good enough while nothing is customized
+    let pool = if config.threads == 0 && config.on_start.is_none() {
+        None
+    } else {
+        match build(config.threads, config.on_start) {
+            Some(pool) => Some(Arc::new(pool)),
+            None => return false,
+        }
+    };
+    // frames already running keep their Arc until they finish
+    *ACTIVE.write().unwrap_or_else(|e| e.into_inner()) = pool;
+    true
+}
+
+/// 0 goes back to a pool sized to the machine.
+pub fn set_active(threads: usize) -> bool {
+    let mut config = CONFIG.lock().unwrap_or_else(|e| e.into_inner());
+    config.threads = threads;
+    rebuild(&config)
+}
+
+pub fn set_start_handler(on_start: Option<StartHandler>) -> bool {
+    let mut config = CONFIG.lock().unwrap_or_else(|e| e.into_inner());
+    config.on_start = on_start;
+    rebuild(&config)
+}
@@ -0,0 +1,305 @@
+/*
+ntsc-rs-obs
+Copyright (C) 2025 eigenpunk
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along
+with this program. If not, see <https://www.gnu.org/licenses/>
+*/
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <obs-module.h>
+#include <util/platform.h>
+#include <util/threading.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <cpuid.h>
+#elif defined(_M_X64) || defined(_M_IX86)
+#include <intrin.h>
+#elif defined(__APPLE__)
+#include <sys/sysctl.h>
+#endif
+
+#include <ntscrs.h>
+
+#include "plugin-support.h"
+#include "autotune.h"
+
+#define AUTOTUNE_FILE "autotune.json"
+#define AUTOTUNE_WARMUP_FRAMES 2
+#define AUTOTUNE_TIMED_FRAMES 6
+#define AUTOTUNE_MAX_CANDIDATES 16
+
+// a smaller pool within this fraction of the fastest one wins, which leaves
+// cores to OBS itself and the encoders
+#define AUTOTUNE_TOLERANCE 0.05
+
+static pthread_mutex_t autotune_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_t autotune_thread;
+static bool autotune_joinable;
+static volatile bool autotune_running;
+static volatile bool autotune_cancel;
+static bool autotune_pending;
+
+static void cpu_model(char *buf, size_t size) {
+    char name[64] = "unknown";
+
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+    uint32_t regs[12] = {0};
+    for (uint32_t i = 0; i < 3; i++) {
+        uint32_t *r = &regs[i * 4];
+#if defined(_M_X64) || defined(_M_IX86)
+        __cpuid((int *)r, (int)(0x80000002 + i));
+#else
+        __get_cpuid(0x80000002 + i, &r[0], &r[1], &r[2], &r[3]);
+#endif
+    }
+    if (regs[0]) {
+        memcpy(name, regs, sizeof(regs));
+        name[sizeof(regs)] = '\0';
+    }
+#elif defined(__APPLE__)
+    size_t len = sizeof(name);
+    if (sysctlbyname("machdep.cpu.brand_string", name, &len, NULL, 0) != 0) {
+        strcpy(name, "unknown");
+    }
+#else
+    FILE *f = fopen("/proc/cpuinfo", "r");
+    char line[256];
+    while (f && fgets(line, sizeof(line), f)) {
+        char *colon = strchr(line, ':');
+        if (colon && (!strncmp(line, "model name", 10) || !strncmp(line, "Model", 5))) {
+            snprintf(name, sizeof(name), "%s", colon + 2);
+            name[strcspn(name, "\n")] = '\0';
+            break;
+        }
+    }
+    if (f) fclose(f);
+#endif
+
+    // brand strings are padded with spaces on some CPUs
+    const char *start = name;
+    while (*start == ' ')
+        start++;
+    size_t len_trimmed = strlen(start);
+    while (len_trimmed > 0 && start[len_trimmed - 1] == ' ')
+        len_trimmed--;
+
+    // the logical core count tells VMs on the same host model apart
+    snprintf(buf, size, "%.*s, %d threads", (int)len_trimmed, start, os_get_logical_cores());
+}
+
+static int compare_double(const void *a, const void *b) {
+    const double x = *(const double *)a, y = *(const double *)b;
+    return (x > y) - (x < y);
+}
+
+static size_t candidate_counts(uint32_t *out) {
+    const int logical = os_get_logical_cores() > 0 ? os_get_logical_cores() : 1;
+    const int physical = os_get_physical_cores() > 0 ? os_get_physical_cores() : logical;
+
+    size_t n = 0;
+    for (int t = 1; t < logical && n < AUTOTUNE_MAX_CANDIDATES - 2; t *= 2)
+        out[n++] = (uint32_t)t;
+    out[n++] = (uint32_t)physical;
+    out[n++] = (uint32_t)logical;
+
+    // sort and drop duplicates
+    for (size_t i = 1; i < n; i++) {
+        for (size_t j = i; j > 0 && out[j - 1] > out[j]; j--) {
+            const uint32_t t = out[j];
+            out[j] = out[j - 1];
+            out[j - 1] = t;
+        }
+    }
+    size_t unique = 0;
+    for (size_t i = 0; i < n; i++) {
+        if (unique == 0 || out[unique - 1] != out[i]) out[unique++] = out[i];
+    }
+    return unique;
+}
+
+// median frame time in ms for the given thread count, or a negative value if
+// the run was cancelled or the pool couldn't be created
+static double benchmark(uint32_t threads, const NtscRsEffectParams *params, const uint8_t *src, uint8_t *work,
+                        uint32_t cx, uint32_t cy) {
+    NtscRsThreadPool *pool = ntscrs_thread_pool_create(threads);
+    if (!pool) return -1.0;
+
+    double times[AUTOTUNE_TIMED_FRAMES];
+    const size_t size = (size_t)cx * cy * 4;
+    size_t n = 0;
+    for (size_t i = 0; i < AUTOTUNE_WARMUP_FRAMES + AUTOTUNE_TIMED_FRAMES; i++) {
+        if (os_atomic_load_bool(&autotune_cancel)) break;
+
+        memcpy(work, src, size);
+        const uint64_t start = os_gettime_ns();
+        ntscrs_thread_pool_apply_effect_to_buffer(pool, *params, cx, cy, work, Rgbx8, i);
+        const uint64_t elapsed = os_gettime_ns() - start;
+        if (i >= AUTOTUNE_WARMUP_FRAMES) times[n++] = (double)elapsed / 1e6;
+    }
+    ntscrs_thread_pool_free(pool);
+
+    if (n < AUTOTUNE_TIMED_FRAMES) return -1.0;
+    qsort(times, n, sizeof(*times), compare_double);
+    return times[n / 2];
+}
+
+static void save_result(const char *cpu, uint32_t threads, uint32_t cx, uint32_t cy, double ms) {
+    char *dir = obs_module_config_path("");
+    char *path = obs_module_config_path(AUTOTUNE_FILE);
+    if (dir && path) {
+        os_mkdirs(dir);
+
+        obs_data_t *data = obs_data_create();
+        obs_data_set_string(data, "cpu", cpu);
+        obs_data_set_string(data, "version", PLUGIN_VERSION);
+        obs_data_set_int(data, "threads", threads);
+        obs_data_set_int(data, "width", cx);
+        obs_data_set_int(data, "height", cy);
+        obs_data_set_double(data, "ms_per_frame", ms);
+        if (!obs_data_save_json_safe(data, path, "tmp", "bak")) {
+            obs_log(LOG_WARNING, "autotune: could not save result to '%s'", path);
+        }
+        obs_data_release(data);
+    }
+    bfree(path);
+    bfree(dir);
+}
+
+static void *autotune_run(void *unused) {
+    UNUSED_PARAMETER(unused);
+    os_set_thread_name("ntscrs-autotune");
+
+    uint32_t cx = 1920, cy = 1080;
+    struct obs_video_info ovi;
+    if (obs_get_video_info(&ovi) && ovi.base_width && ovi.base_height) {
+        cx = ovi.base_width;
+        cy = ovi.base_height;
+    }
+
+    // a gradient with hard edges; the effect's cost barely depends on content
+    const size_t size = (size_t)cx * cy * 4;
+    uint8_t *src = bmalloc(size);
+    uint8_t *work = bmalloc(size);
+    for (uint32_t y = 0; y < cy; y++) {
+        uint8_t *row = src + (size_t)y * cx * 4;
+        for (uint32_t x = 0; x < cx; x++) {
+            row[x * 4 + 0] = (uint8_t)(x * 255 / cx);
+            row[x * 4 + 1] = (uint8_t)(y * 255 / cy);
+            row[x * 4 + 2] = ((x / 32) ^ (y / 32)) & 1 ? 235 : 16;
+            row[x * 4 + 3] = 255;
+        }
+    }
+
+    NtscRsEffectParams params;
+    ntscrs_default_effect_params(&params);
+
+    uint32_t candidates[AUTOTUNE_MAX_CANDIDATES];
+    double results[AUTOTUNE_MAX_CANDIDATES];
+    const size_t n = candidate_counts(candidates);
+    obs_log(LOG_INFO, "autotune: benchmarking %zu thread counts at %ux%u", n, cx, cy);
+
+    double fastest = -1.0;
+    for (size_t i = 0; i < n; i++) {
+        results[i] = benchmark(candidates[i], &params, src, work, cx, cy);
+        if (os_atomic_load_bool(&autotune_cancel)) break;
+        obs_log(LOG_INFO, "autotune: %u threads: %.2f ms/frame", candidates[i], results[i]);
+        if (results[i] > 0.0 && (fastest < 0.0 || results[i] < fastest)) fastest = results[i];
+    }
+
+    if (!os_atomic_load_bool(&autotune_cancel) && fastest > 0.0) {
+        size_t best = 0;
+        while (best < n && !(results[best] > 0.0 && results[best] <= fastest * (1.0 + AUTOTUNE_TOLERANCE)))
+            best++;
+
+        char cpu[128];
+        cpu_model(cpu, sizeof(cpu));
+        if (ntscrs_set_thread_count(candidates[best])) {
+            obs_log(LOG_INFO, "autotune: using %u threads on %s", candidates[best], cpu);
+            save_result(cpu, candidates[best], cx, cy, results[best]);
+        }
+    }
+
+    bfree(work);
+    bfree(src);
+    os_atomic_store_bool(&autotune_running, false);
+    return NULL;
+}
+
+void autotune_init(void) {
+    char *path = obs_module_config_path(AUTOTUNE_FILE);
+    if (!path) return;
+
+    char cpu[128];
+    cpu_model(cpu, sizeof(cpu));
+
+    obs_data_t *data = obs_data_create_from_json_file_safe(path, "bak");
+    const uint32_t threads = data ? (uint32_t)obs_data_get_int(data, "threads") : 0;
+    const bool valid = data && threads > 0 && strcmp(obs_data_get_string(data, "cpu"), cpu) == 0 &&
+                       strcmp(obs_data_get_string(data, "version"), PLUGIN_VERSION) == 0;
+
+    if (valid && ntscrs_set_thread_count(threads)) {
+        obs_log(LOG_INFO, "autotune: using stored result of %u threads", threads);
+    } else {
+        // CPU or plugin changed, or never tuned
+        autotune_pending = true;
+    }
+
+    obs_data_release(data);
+    bfree(path);
+}
+
+void autotune_first_use(void) {
+    pthread_mutex_lock(&autotune_mutex);
+    const bool start = autotune_pending;
+    autotune_pending = false;
+    pthread_mutex_unlock(&autotune_mutex);
+
+    if (start) autotune_start();
+}
+
+bool autotune_start(void) {
+    pthread_mutex_lock(&autotune_mutex);
+    if (os_atomic_load_bool(&autotune_running)) {
+        pthread_mutex_unlock(&autotune_mutex);
+        return false;
+    }
+    if (autotune_joinable) {
+        pthread_join(autotune_thread, NULL);
+        autotune_joinable = false;
+    }
+
+    os_atomic_store_bool(&autotune_cancel, false);
+    os_atomic_store_bool(&autotune_running, true);
+    if (pthread_create(&autotune_thread, NULL, autotune_run, NULL) == 0) {
+        autotune_joinable = true;
+    } else {
+        os_atomic_store_bool(&autotune_running, false);
+        obs_log(LOG_ERROR, "autotune: failed to start thread");
+    }
+    const bool started = autotune_joinable;
+    pthread_mutex_unlock(&autotune_mutex);
+    return started;
+}
+
+void autotune_shutdown(void) {
+    pthread_mutex_lock(&autotune_mutex);
+    os_atomic_store_bool(&autotune_cancel, true);
+    if (autotune_joinable) {
+        pthread_join(autotune_thread, NULL);
+        autotune_joinable = false;
+    }
+    pthread_mutex_unlock(&autotune_mutex);
+}
@@ -0,0 +1,38 @@
+/*
+ntsc-rs-obs
+Copyright (C) 2025 eigenpunk
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along
+with this program. If not, see <https://www.gnu.org/licenses/>
+*/
+
+#pragma once
+
+#include <stdbool.h>
+
+// Picks the effect's worker thread count for this machine by benchmarking
+// candidate counts on synthetic frames at the canvas size, on a background
+// thread. The winner is stored in the module config directory and reused
+// until the CPU model or plugin version changes.
+
+// loads and applies a stored result; call from obs_module_load
+void autotune_init(void);
+
+// starts a run if no stored result was usable; call when a filter is created
+void autotune_first_use(void);
+
+// starts a run unless one is in progress; returns false if one was
+bool autotune_start(void);
+
+// cancels a run in progress and waits for it; call from obs_module_unload
+void autotune_shutdown(void);
@@ -0,0 +1,162 @@
+/*
+ntsc-rs-obs
+Copyright (C) 2025 eigenpunk
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along
+with this program. If not, see <https://www.gnu.org/licenses/>
+*/
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <util/bmem.h>
+
+#include "dirty-rows.h"
+
+// Bands start on a multiple of this many rows so that the per-line chroma
+// phase pattern (period of at most 4 lines) and field parity match what the
+// effect sees when it processes the whole frame.
+#define DIRTY_ROWS_ALIGN 8
+
+void dirty_rows_free(struct dirty_rows *dr) {
+    bfree(dr->prev_in);
+    bfree(dr->out);
+    bfree(dr->band);
+    memset(dr, 0, sizeof(*dr));
+}
+
+bool dirty_rows_resize(struct dirty_rows *dr, size_t linesize, uint32_t height) {
+    if (dr->prev_in && dr->linesize == linesize && dr->height == height) return true;
+
+    dirty_rows_free(dr);
+    const size_t size = linesize * height;
+    dr->prev_in = bmalloc(size);
+    dr->out = bmalloc(size);
+    dr->band = bmalloc(size);
+    if (!dr->prev_in || !dr->out || !dr->band) {
+        dirty_rows_free(dr);
+        return false;
+    }
+
+    dr->linesize = linesize;
+    dr->height = height;
+    return true;
+}
+
+bool dirty_rows_eligible(const NtscRsEffectParams *p) {
+    if (p->enable_head_switching || p->enable_tracking_noise || p->enable_composite_noise ||
+        p->enable_luma_noise || p->enable_chroma_noise) {
+        return false;
+    }
+    if (p->snow_intensity != 0.0f || p->chroma_phase_noise_intensity != 0.0f) return false;
+    if (p->enable_vhs && (p->vhs_settings.enable_edge_wave || p->vhs_settings.chroma_loss != 0.0f)) return false;
+
+    // alternating/interleaved fields change with every frame
+    if (p->use_field != UseFieldUpper && p->use_field != UseFieldLower && p->use_field != UseFieldBoth) return false;
+
+    // bands are shorter than the frame, which would change the scale
+    return !p->scale.scale_with_video_size;
+}
+
+uint32_t dirty_rows_halo(const NtscRsEffectParams *p) {
+    uint32_t reach = 0;
+    if (p->chroma_vert_blend) reach += 1;
+    if (p->chroma_demodulation == ChromaDemodFilterOneLineComb) reach += 1;
+    if (p->chroma_demodulation == ChromaDemodFilterTwoLineComb) reach += 2;
+    reach += (uint32_t)abs(p->chroma_delay_vertical);
+
+    // single-field modes work on every other row and double the result
+    const bool single_field = p->use_field == UseFieldUpper || p->use_field == UseFieldLower;
+    return (single_field ? 2 * reach : reach) + 1;
+}
+
+static inline bool row_changed(const struct dirty_rows *dr, const uint8_t *in, uint32_t y) {
+    // libc memcmp is vectorized on every platform we build for
+    return memcmp(in + y * dr->linesize, dr->prev_in + y * dr->linesize, dr->linesize) != 0;
+}
+
+size_t dirty_rows_find(const struct dirty_rows *dr, const uint8_t *in, uint32_t halo, struct dirty_band *bands,
+                       size_t max_bands) {
+    const uint32_t h = dr->height;
+    size_t n = 0;
+    uint32_t processed = 0;
+
+    for (uint32_t y = 0; y < h;) {
+        if (!row_changed(dr, in, y)) {
+            y++;
+            continue;
+        }
+
+        // grow the run over clean gaps too short to keep two bands apart
+        uint32_t changed_begin = y, changed_end = y + 1, gap = 0;
+        for (y = changed_end; y < h; y++) {
+            if (row_changed(dr, in, y)) {
+                changed_end = y + 1;
+                gap = 0;
+            } else if (++gap > 2 * halo + DIRTY_ROWS_ALIGN) {
+                break;
+            }
+        }
+
+        if (n == max_bands) return DIRTY_ROWS_ALL;
+
+        struct dirty_band *b = &bands[n++];
+        b->write_begin = changed_begin > halo ? changed_begin - halo : 0;
+        b->write_end = changed_end + halo < h ? changed_end + halo : h;
+        b->process_begin = (b->write_begin > halo ? b->write_begin - halo : 0) & ~(uint32_t)(DIRTY_ROWS_ALIGN - 1);
+        b->process_end = b->write_end + halo < h ? b->write_end + halo : h;
+
+        processed += b->process_end - b->process_begin;
+        if (processed * 2 > h) return DIRTY_ROWS_ALL;
+    }
+
+    return n;
+}
+
+static inline void apply(uint8_t *buf, const NtscRsEffect *effect, bool draft, uint32_t width, uint32_t height,
+                         NtscRsPixelFormat pix_fmt, size_t frame) {
+    if (draft) {
+        ntscrs_effect_apply_draft(effect, width, height, buf, pix_fmt, frame);
+    } else {
+        ntscrs_effect_apply(effect, width, height, buf, pix_fmt, frame);
+    }
+}
+
+void dirty_rows_apply_full(struct dirty_rows *dr, uint8_t *buf, const NtscRsEffect *effect, bool draft,
+                           uint32_t width, NtscRsPixelFormat pix_fmt, size_t frame) {
+    memcpy(dr->prev_in, buf, dr->linesize * dr->height);
+    apply(buf, effect, draft, width, dr->height, pix_fmt, frame);
+    memcpy(dr->out, buf, dr->linesize * dr->height);
+
+    dr->valid = true;
+    dr->draft = draft;
+    dr->frame = frame;
+}
+
+const uint8_t *dirty_rows_apply_bands(struct dirty_rows *dr, const uint8_t *in, const struct dirty_band *bands,
+                                      size_t n, const NtscRsEffect *effect, bool draft, uint32_t width,
+                                      NtscRsPixelFormat pix_fmt) {
+    const size_t linesize = dr->linesize;
+    for (size_t i = 0; i < n; i++) {
+        const struct dirty_band *b = &bands[i];
+        const uint32_t rows = b->process_end - b->process_begin;
+        const uint8_t *band_in = in + b->process_begin * linesize;
+
+        memcpy(dr->band, band_in, rows * linesize);
+        apply(dr->band, effect, draft, width, rows, pix_fmt, dr->frame);
+        memcpy(dr->out + b->write_begin * linesize, dr->band + (b->write_begin - b->process_begin) * linesize,
+               (b->write_end - b->write_begin) * linesize);
+        memcpy(dr->prev_in + b->process_begin * linesize, band_in, rows * linesize);
+    }
+    return dr->out;
+}
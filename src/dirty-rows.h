@@ -0,0 +1,82 @@
+/*
+ntsc-rs-obs
+Copyright (C) 2025 eigenpunk
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along
+with this program. If not, see <https://www.gnu.org/licenses/>
+*/
+
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include <ntscrs.h>
+
+// Incremental processing for sources where only a few rows change between
+// frames. The previous input and output are kept; rows that changed are
+// found by comparing against the previous input, and the effect is re-run
+// only on bands around them, wide enough to cover every row the vertical
+// stages let a change reach.
+
+#define DIRTY_ROWS_ALL ((size_t)-1)
+
+struct dirty_band {
+    uint32_t process_begin, process_end; // rows fed to the effect
+    uint32_t write_begin, write_end;     // rows of its output that are kept
+};
+
+struct dirty_rows {
+    uint8_t *prev_in; // input of the previous frame
+    uint8_t *out;     // output of the previous frame
+    uint8_t *band;    // scratch for one band
+
+    size_t linesize;
+    uint32_t height;
+
+    bool valid;
+    uint64_t generation;
+    bool draft; // the output was made with the draft path
+    size_t frame;
+};
+
+void dirty_rows_free(struct dirty_rows *dr);
+
+// (Re)allocates for the given frame size; invalidates on any change.
+bool dirty_rows_resize(struct dirty_rows *dr, size_t linesize, uint32_t height);
+
+// Reusing rows is only valid when the effect's output for a row depends on
+// nothing but nearby input rows, i.e. no noise or other per-frame variation.
+bool dirty_rows_eligible(const NtscRsEffectParams *p);
+
+// How many rows above and below a changed row can be affected by it.
+uint32_t dirty_rows_halo(const NtscRsEffectParams *p);
+
+// Compares in with the previous input and returns the number of bands that
+// need processing, or DIRTY_ROWS_ALL when redoing the whole frame is cheaper.
+size_t dirty_rows_find(const struct dirty_rows *dr, const uint8_t *in, uint32_t halo, struct dirty_band *bands,
+                       size_t max_bands);
+
+// Runs effect (its draft path if draft) over the whole of buf, in place, and
+// keeps the input and output as the previous frame. Marks dr valid; the
+// caller sets the generation.
+void dirty_rows_apply_full(struct dirty_rows *dr, uint8_t *buf, const NtscRsEffect *effect, bool draft,
+                           uint32_t width, NtscRsPixelFormat pix_fmt, size_t frame);
+
+// Runs effect on the bands dirty_rows_find returned for in, with the frame
+// number of the last full pass, and merges them into the previous output.
+// Returns the complete output.
+const uint8_t *dirty_rows_apply_bands(struct dirty_rows *dr, const uint8_t *in, const struct dirty_band *bands,
+                                      size_t n, const NtscRsEffect *effect, bool draft, uint32_t width,
+                                      NtscRsPixelFormat pix_fmt);
@@ -0,0 +1,95 @@
+/*
+ntsc-rs-obs
+Copyright (C) 2025 eigenpunk
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along
+with this program. If not, see <https://www.gnu.org/licenses/>
+*/
+
+#include <obs-module.h>
+#include <util/threading.h>
+
+#include "plugin-support.h"
+#include "effect-cache.h"
+
+struct effect_entry {
+    uint64_t hash;
+    NtscRsEffect *effect;
+    size_t refs;
+    struct effect_entry *next;
+};
+
+// taken by the parameter builder and the media pipeline's thread
+static pthread_mutex_t cache_mutex = PTHREAD_MUTEX_INITIALIZER;
+static struct effect_entry *entries;
+static size_t entry_count;
+static size_t ref_count;
+
+NtscRsEffect *effect_cache_acquire(const NtscRsEffectParams *params, uint64_t hash) {
+    pthread_mutex_lock(&cache_mutex);
+    struct effect_entry *e = entries;
+    while (e && e->hash != hash)
+        e = e->next;
+
+    if (!e) {
+        e = bzalloc(sizeof(*e));
+        e->hash = hash;
+        e->effect = ntscrs_effect_create(*params);
+        e->next = entries;
+        entries = e;
+        entry_count++;
+        obs_log(LOG_DEBUG, "effect cache: built effect %016llx, %zu held", (unsigned long long)hash, entry_count);
+    }
+    e->refs++;
+    ref_count++;
+    NtscRsEffect *effect = e->effect;
+    pthread_mutex_unlock(&cache_mutex);
+    return effect;
+}
+
+void effect_cache_release(NtscRsEffect *effect) {
+    if (!effect) return;
+
+    pthread_mutex_lock(&cache_mutex);
+    struct effect_entry **link = &entries;
+    while (*link && (*link)->effect != effect)
+        link = &(*link)->next;
+
+    struct effect_entry *e = *link;
+    if (!e) {
+        pthread_mutex_unlock(&cache_mutex);
+        obs_log(LOG_ERROR, "effect cache: released an effect it doesn't hold");
+        return;
+    }
+
+    ref_count--;
+    if (--e->refs == 0) {
+        *link = e->next;
+        entry_count--;
+    } else {
+        e = NULL;
+    }
+    pthread_mutex_unlock(&cache_mutex);
+
+    if (e) {
+        ntscrs_effect_free(e->effect);
+        bfree(e);
+    }
+}
+
+void effect_cache_stats(size_t *effects, size_t *refs) {
+    pthread_mutex_lock(&cache_mutex);
+    *effects = entry_count;
+    *refs = ref_count;
+    pthread_mutex_unlock(&cache_mutex);
+}
@@ -0,0 +1,41 @@
+/*
+ntsc-rs-obs
+Copyright (C) 2025 eigenpunk
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along
+with this program. If not, see <https://www.gnu.org/licenses/>
+*/
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <ntscrs.h>
+
+// Prepared effects, shared module-wide by every filter whose settings come
+// out the same (by ntscrs_params_hash, which ignores values kept for disabled
+// stages). A scene collection where dozens of filters use one preset then
+// holds and builds one effect for all of them instead of one per filter.
+// Effects are immutable once built and may be applied from several threads
+// at once.
+
+// Returns the effect for params, whose ntscrs_params_hash is hash, building
+// it if no one holds it yet. Each call takes a reference.
+NtscRsEffect *effect_cache_acquire(const NtscRsEffectParams *params, uint64_t hash);
+
+// drops a reference taken by effect_cache_acquire; does nothing for NULL
+void effect_cache_release(NtscRsEffect *effect);
+
+// distinct effects held and the references to them
+void effect_cache_stats(size_t *effects, size_t *refs);
@@ -0,0 +1,108 @@
+/*
+ntsc-rs-obs
+Copyright (C) 2025 eigenpunk
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along
+with this program. If not, see <https://www.gnu.org/licenses/>
+*/
+
+#include <obs-module.h>
+#include <util/threading.h>
+
+#include "frame-pool.h"
+#include "mem-stats.h"
+
+// a few frame sizes' worth; more buffers than this are small ones that
+// aren't worth keeping anyway
+#define FRAME_POOL_SIZE 16
+
+struct frame_pool_entry {
+    void *buf; // NULL for an unused entry
+    size_t size;
+    uint64_t age; // order given back in, larger is newer
+};
+
+static pthread_mutex_t pool_mutex = PTHREAD_MUTEX_INITIALIZER;
+static struct frame_pool_entry pool[FRAME_POOL_SIZE];
+static uint64_t pool_bytes;
+static uint64_t pool_age;
+static struct mem_usage pool_mem;
+
+// with pool_mutex held
+static void account(void) {
+    const struct mem_usage usage = {.system = pool_bytes};
+    mem_stats_set(&pool_mem, &usage);
+}
+
+static struct frame_pool_entry *oldest(void) {
+    struct frame_pool_entry *found = NULL;
+    for (size_t i = 0; i < FRAME_POOL_SIZE; i++) {
+        if (pool[i].buf && (!found || pool[i].age < found->age)) found = &pool[i];
+    }
+    return found;
+}
+
+void *frame_pool_get(size_t size) {
+    void *buf = NULL;
+    pthread_mutex_lock(&pool_mutex);
+    struct frame_pool_entry *found = NULL;
+    for (size_t i = 0; i < FRAME_POOL_SIZE; i++) {
+        if (pool[i].buf && pool[i].size == size && (!found || pool[i].age > found->age)) found = &pool[i];
+    }
+    if (found) {
+        buf = found->buf;
+        found->buf = NULL;
+        pool_bytes -= size;
+        account();
+    }
+    pthread_mutex_unlock(&pool_mutex);
+
+    return buf ? buf : bzalloc(size);
+}
+
+void frame_pool_put(void *buf, size_t size) {
+    if (!buf) return;
+
+    pthread_mutex_lock(&pool_mutex);
+    // make room, oldest first; a buffer larger than the cap is kept on its own
+    struct frame_pool_entry *free_entry = NULL;
+    for (;;) {
+        for (size_t i = 0; i < FRAME_POOL_SIZE && !free_entry; i++) {
+            if (!pool[i].buf) free_entry = &pool[i];
+        }
+        if (free_entry && (pool_bytes + size <= FRAME_POOL_MAX_BYTES || pool_bytes == 0)) break;
+
+        struct frame_pool_entry *e = oldest();
+        bfree(e->buf);
+        e->buf = NULL;
+        pool_bytes -= e->size;
+    }
+
+    free_entry->buf = buf;
+    free_entry->size = size;
+    free_entry->age = ++pool_age;
+    pool_bytes += size;
+    account();
+    pthread_mutex_unlock(&pool_mutex);
+}
+
+void frame_pool_shutdown(void) {
+    pthread_mutex_lock(&pool_mutex);
+    for (size_t i = 0; i < FRAME_POOL_SIZE; i++) {
+        bfree(pool[i].buf);
+        pool[i].buf = NULL;
+    }
+    pool_bytes = 0;
+    account();
+    pthread_mutex_unlock(&pool_mutex);
+}
@@ -0,0 +1,42 @@
+/*
+ntsc-rs-obs
+Copyright (C) 2025 eigenpunk
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along
+with this program. If not, see <https://www.gnu.org/licenses/>
+*/
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+// CPU frame buffers given back by filters that went idle or changed size,
+// kept so that a filter shown again gets a buffer without allocating and
+// zeroing a whole frame on the render thread. Any filter can take any buffer
+// of the right size. The pool holds at most FRAME_POOL_MAX_BYTES, dropping
+// the buffers given back longest ago first, or a single buffer of any size
+// (a 4K RGBA16 frame alone is larger), and counts towards the all-filters
+// total in mem-stats.h.
+
+#define FRAME_POOL_MAX_BYTES (64ULL << 20)
+
+// A buffer of size bytes, reused if the pool has one; contents are whatever
+// the last user left. Callable from any thread, as is frame_pool_put.
+void *frame_pool_get(size_t size);
+
+// gives buf, of size bytes, to the pool (or frees it); does nothing for NULL
+void frame_pool_put(void *buf, size_t size);
+
+// frees every pooled buffer; call from obs_module_unload
+void frame_pool_shutdown(void);
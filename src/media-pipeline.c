@@ -0,0 +1,423 @@
+/*
+ntsc-rs-obs
+Copyright (C) 2025 eigenpunk
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along
+with this program. If not, see <https://www.gnu.org/licenses/>
+*/
+
+#include <math.h>
+#include <string.h>
+
+#include <obs-module.h>
+#include <util/platform.h>
+#include <util/threading.h>
+
+#include "plugin-support.h"
+#include "media-pipeline.h"
+#include "effect-cache.h"
+
+// frames further apart than this are a pause or a seek, not the frame rate
+#define MAX_FRAME_INTERVAL_NS 1000000000ULL
+
+// intervals averaged before the frame rate counts as known
+#define SETTLED_INTERVALS 8
+
+enum slot_state {
+    SLOT_FREE,
+    SLOT_QUEUED,
+    SLOT_RUNNING,
+    SLOT_DONE,
+    SLOT_SHOWN, // returned by the last push
+};
+
+struct media_slot {
+    enum slot_state state;
+    uint64_t seq;
+
+    // the source's frame, held until a worker has copied it
+    struct obs_source_frame *in;
+
+    // Processed frame. It holds one reference while the pipeline owns it;
+    // when it's returned, libobs takes and releases another.
+    struct obs_source_frame *out;
+
+    // The slot's own reference to the parameters' effect: the filter's is
+    // released when a newer set is published, which may happen mid-frame.
+    NtscRsEffect *effect;
+    uint64_t effect_hash;
+
+    NtscRsPixelFormat pix_fmt;
+    bool draft;
+    size_t frame_num;
+    uint64_t cpu_ns;
+};
+
+struct media_pipeline {
+    pthread_mutex_t mutex;
+    pthread_cond_t queued;
+    pthread_cond_t done;
+    pthread_t threads[MEDIA_PIPELINE_MAX_DEPTH];
+    uint32_t n_threads;
+    bool stop;
+
+    // depth frames in flight at most, so depth slots
+    uint32_t depth;
+    struct media_slot slots[MEDIA_PIPELINE_MAX_DEPTH];
+    obs_source_t *parent;
+    uint64_t next_seq; // given to the next frame queued
+    uint64_t next_out; // seq of the next frame to return
+    struct media_slot *shown;
+
+    // caller only
+    uint64_t last_timestamp;
+    uint64_t interval_ns;
+    uint32_t intervals;
+};
+
+static inline bool is_yuv(enum video_format format) {
+    return format == VIDEO_FORMAT_I420 || format == VIDEO_FORMAT_NV12 || format == VIDEO_FORMAT_I444;
+}
+
+bool media_pipeline_supports(enum video_format format) {
+    return is_yuv(format) || format == VIDEO_FORMAT_RGBA || format == VIDEO_FORMAT_BGRA ||
+           format == VIDEO_FORMAT_BGRX;
+}
+
+// Packed 4-byte rows with no padding, as the effect takes them, in one
+// allocation so that obs_source_frame_destroy can free it too.
+static struct obs_source_frame *frame_create(enum video_format format, uint32_t cx, uint32_t cy) {
+    struct obs_source_frame *frame = bzalloc(sizeof(*frame));
+    frame->data[0] = bmalloc((size_t)cx * cy * 4);
+    frame->linesize[0] = cx * 4;
+    frame->width = cx;
+    frame->height = cy;
+    frame->format = format;
+    frame->full_range = true;
+    frame->refs = 1;
+    return frame;
+}
+
+// Gives up the pipeline's reference to a slot's frame. If nothing else holds
+// it, it stays with the slot for reuse; if something does (another async
+// filter above this one may keep frames, as the async delay filter does),
+// the last one to release it frees it.
+static void slot_release_output(struct media_slot *slot) {
+    if (!slot->out) return;
+    if (os_atomic_dec_long(&slot->out->refs) == 0) {
+        os_atomic_set_long(&slot->out->refs, 1);
+    } else {
+        slot->out = NULL;
+    }
+}
+
+static void copy_packed(struct obs_source_frame *dst, const struct obs_source_frame *src) {
+    const size_t row = (size_t)src->width * 4;
+    for (uint32_t y = 0; y < src->height; y++) {
+        memcpy(dst->data[0] + (size_t)y * dst->linesize[0], src->data[0] + (size_t)y * src->linesize[0], row);
+    }
+}
+
+// color_matrix maps [y, u, v, 1] in 0..1 to RGB, one row per channel; this
+// is it in 16.16 fixed point for 8-bit samples
+struct yuv_coeffs {
+    int32_t m[3][4];
+    int32_t min[3], max[3];
+};
+
+static void yuv_coeffs(struct yuv_coeffs *c, const struct obs_source_frame *frame) {
+    for (int i = 0; i < 3; i++) {
+        for (int j = 0; j < 3; j++)
+            c->m[i][j] = (int32_t)lroundf(frame->color_matrix[i * 4 + j] * 65536.0f);
+        c->m[i][3] = (int32_t)lroundf(frame->color_matrix[i * 4 + 3] * 255.0f * 65536.0f) + 32768;
+
+        // sources that don't set a range get full range
+        c->min[i] = (int32_t)lroundf(frame->color_range_min[i] * 255.0f);
+        c->max[i] = (int32_t)lroundf(frame->color_range_max[i] * 255.0f);
+        if (c->max[i] <= c->min[i]) {
+            c->min[i] = 0;
+            c->max[i] = 255;
+        }
+    }
+}
+
+static inline int32_t clamp_i32(int32_t x, int32_t lo, int32_t hi) {
+    return x < lo ? lo : x > hi ? hi : x;
+}
+
+static inline uint8_t yuv_channel(int32_t luma_coeff, int32_t chroma_term, int32_t y) {
+    return (uint8_t)clamp_i32((luma_coeff * y + chroma_term) >> 16, 0, 255);
+}
+
+static void convert_yuv(struct obs_source_frame *dst, const struct obs_source_frame *src) {
+    struct yuv_coeffs c;
+    yuv_coeffs(&c, src);
+
+    // chroma is taken from the nearest sample, which is what the effect's
+    // own chroma lowpass makes of it anyway
+    const uint32_t shift = src->format == VIDEO_FORMAT_I444 ? 0 : 1;
+    const size_t step = src->format == VIDEO_FORMAT_NV12 ? 2 : 1;
+
+    // in locals, as the compiler can't tell that the output doesn't alias them
+    const uint32_t cx = src->width, cy = src->height;
+    const int32_t r_y = c.m[0][0], g_y = c.m[1][0], b_y = c.m[2][0];
+    const int32_t y_min = c.min[0], y_max = c.max[0];
+
+    for (uint32_t y = 0; y < cy; y++) {
+        const uint8_t *luma = src->data[0] + (size_t)y * src->linesize[0];
+        const size_t chroma_row = (size_t)(y >> shift);
+        const uint8_t *u_row = src->data[1] + chroma_row * src->linesize[1];
+        const uint8_t *v_row = src->format == VIDEO_FORMAT_NV12 ? u_row + 1
+                                                                 : src->data[2] + chroma_row * src->linesize[2];
+        uint8_t *out = dst->data[0] + (size_t)y * dst->linesize[0];
+
+        for (uint32_t x = 0; x < cx;) {
+            const size_t ci = (size_t)(x >> shift) * step;
+            const int32_t u = clamp_i32(u_row[ci], c.min[1], c.max[1]);
+            const int32_t v = clamp_i32(v_row[ci], c.min[2], c.max[2]);
+            const int32_t r_uv = c.m[0][1] * u + c.m[0][2] * v + c.m[0][3];
+            const int32_t g_uv = c.m[1][1] * u + c.m[1][2] * v + c.m[1][3];
+            const int32_t b_uv = c.m[2][1] * u + c.m[2][2] * v + c.m[2][3];
+
+            // every luma sample that shares this chroma sample
+            const uint32_t end = (x | ((1u << shift) - 1)) + 1;
+            for (; x < end && x < cx; x++) {
+                const int32_t l = clamp_i32(luma[x], y_min, y_max);
+                out[x * 4 + 0] = yuv_channel(r_y, r_uv, l);
+                out[x * 4 + 1] = yuv_channel(g_y, g_uv, l);
+                out[x * 4 + 2] = yuv_channel(b_y, b_uv, l);
+                out[x * 4 + 3] = 255;
+            }
+        }
+    }
+}
+
+static void process(struct media_slot *slot, obs_source_t *parent) {
+    const uint64_t start = os_gettime_ns();
+    struct obs_source_frame *out = slot->out;
+
+    if (is_yuv(slot->in->format)) {
+        convert_yuv(out, slot->in);
+    } else {
+        copy_packed(out, slot->in);
+    }
+    obs_source_release_frame(parent, slot->in);
+    slot->in = NULL;
+
+    if (slot->draft) {
+        ntscrs_effect_apply_draft(slot->effect, out->width, out->height, out->data[0], slot->pix_fmt,
+                                  slot->frame_num);
+    } else {
+        ntscrs_effect_apply(slot->effect, out->width, out->height, out->data[0], slot->pix_fmt, slot->frame_num);
+    }
+    slot->cpu_ns = os_gettime_ns() - start;
+}
+
+static struct media_slot *oldest_queued(struct media_pipeline *mp) {
+    struct media_slot *oldest = NULL;
+    for (uint32_t i = 0; i < mp->depth; i++) {
+        struct media_slot *slot = &mp->slots[i];
+        if (slot->state == SLOT_QUEUED && (!oldest || slot->seq < oldest->seq)) oldest = slot;
+    }
+    return oldest;
+}
+
+static void *media_worker(void *data) {
+    struct media_pipeline *mp = data;
+    os_set_thread_name("ntscrs-media");
+
+    pthread_mutex_lock(&mp->mutex);
+    for (;;) {
+        struct media_slot *slot = NULL;
+        while (!mp->stop && !(slot = oldest_queued(mp)))
+            pthread_cond_wait(&mp->queued, &mp->mutex);
+        // frames still queued are given back by media_pipeline_destroy
+        if (!slot) break;
+
+        slot->state = SLOT_RUNNING;
+        obs_source_t *parent = mp->parent;
+        pthread_mutex_unlock(&mp->mutex);
+
+        process(slot, parent);
+
+        pthread_mutex_lock(&mp->mutex);
+        slot->state = SLOT_DONE;
+        pthread_cond_broadcast(&mp->done);
+    }
+    pthread_mutex_unlock(&mp->mutex);
+    return NULL;
+}
+
+struct media_pipeline *media_pipeline_create(uint32_t depth) {
+    if (depth < 1) depth = 1;
+    if (depth > MEDIA_PIPELINE_MAX_DEPTH) depth = MEDIA_PIPELINE_MAX_DEPTH;
+
+    struct media_pipeline *mp = bzalloc(sizeof(*mp));
+    mp->depth = depth;
+    pthread_mutex_init(&mp->mutex, NULL);
+    pthread_cond_init(&mp->queued, NULL);
+    pthread_cond_init(&mp->done, NULL);
+
+    for (uint32_t i = 0; i < depth; i++) {
+        if (pthread_create(&mp->threads[i], NULL, media_worker, mp) != 0) {
+            obs_log(LOG_ERROR, "media pipeline: failed to start worker thread");
+            media_pipeline_destroy(mp);
+            return NULL;
+        }
+        mp->n_threads++;
+    }
+    return mp;
+}
+
+void media_pipeline_destroy(struct media_pipeline *mp) {
+    if (!mp) return;
+
+    pthread_mutex_lock(&mp->mutex);
+    mp->stop = true;
+    pthread_cond_broadcast(&mp->queued);
+    pthread_mutex_unlock(&mp->mutex);
+    for (uint32_t i = 0; i < mp->n_threads; i++)
+        pthread_join(mp->threads[i], NULL);
+
+    for (uint32_t i = 0; i < mp->depth; i++) {
+        struct media_slot *slot = &mp->slots[i];
+        if (slot->in) obs_source_release_frame(mp->parent, slot->in);
+        slot_release_output(slot);
+        obs_source_frame_destroy(slot->out);
+        effect_cache_release(slot->effect);
+    }
+
+    pthread_cond_destroy(&mp->done);
+    pthread_cond_destroy(&mp->queued);
+    pthread_mutex_destroy(&mp->mutex);
+    bfree(mp);
+}
+
+uint32_t media_pipeline_depth(const struct media_pipeline *mp) {
+    return mp->depth;
+}
+
+// Gets a free slot ready for in. Only the caller touches free slots, so this
+// needs no lock.
+static void slot_prepare(struct media_slot *slot, const struct obs_source_frame *in,
+                         const struct ntscrs_params *params, bool draft, size_t frame_num) {
+    const enum video_format format = is_yuv(in->format) ? VIDEO_FORMAT_RGBA : in->format;
+    if (slot->out &&
+        (slot->out->width != in->width || slot->out->height != in->height || slot->out->format != format)) {
+        obs_source_frame_destroy(slot->out);
+        slot->out = NULL;
+    }
+    if (!slot->out) slot->out = frame_create(format, in->width, in->height);
+    slot->out->timestamp = in->timestamp;
+    slot->out->flip = in->flip;
+
+    if (!slot->effect || slot->effect_hash != params->hash) {
+        effect_cache_release(slot->effect);
+        slot->effect = effect_cache_acquire(&params->ntsc, params->hash);
+        slot->effect_hash = params->hash;
+    }
+
+    slot->pix_fmt = format == VIDEO_FORMAT_RGBA ? Rgbx8 : Bgrx8;
+    slot->draft = draft;
+    slot->frame_num = frame_num;
+}
+
+struct obs_source_frame *media_pipeline_push(struct media_pipeline *mp, obs_source_t *parent,
+                                             struct obs_source_frame *in, const struct ntscrs_params *params,
+                                             bool draft, size_t frame_num, uint64_t *cpu_ns) {
+    *cpu_ns = 0;
+
+    // a worker may release in as soon as it's queued
+    const uint64_t timestamp = in->timestamp;
+
+    pthread_mutex_lock(&mp->mutex);
+    mp->parent = parent;
+    if (mp->shown) {
+        slot_release_output(mp->shown);
+        mp->shown->state = SLOT_FREE;
+        mp->shown = NULL;
+    }
+    struct media_slot *slot = NULL;
+    for (uint32_t i = 0; i < mp->depth && !slot; i++) {
+        if (mp->slots[i].state == SLOT_FREE) slot = &mp->slots[i];
+    }
+    pthread_mutex_unlock(&mp->mutex);
+
+    // every push leaves at most depth - 1 frames in flight, so there always
+    // is one
+    if (!slot) {
+        obs_source_release_frame(parent, in);
+        return NULL;
+    }
+    slot_prepare(slot, in, params, draft, frame_num);
+    slot->in = in;
+
+    pthread_mutex_lock(&mp->mutex);
+    slot->state = SLOT_QUEUED;
+    slot->seq = mp->next_seq++;
+    pthread_cond_signal(&mp->queued);
+
+    struct obs_source_frame *out = NULL;
+    if (mp->next_seq - mp->next_out >= mp->depth) {
+        struct media_slot *oldest = NULL;
+        for (uint32_t i = 0; i < mp->depth && !oldest; i++) {
+            if (mp->slots[i].seq == mp->next_out && mp->slots[i].state != SLOT_FREE) oldest = &mp->slots[i];
+        }
+        while (oldest->state != SLOT_DONE)
+            pthread_cond_wait(&mp->done, &mp->mutex);
+
+        oldest->state = SLOT_SHOWN;
+        mp->shown = oldest;
+        mp->next_out++;
+        *cpu_ns = oldest->cpu_ns;
+
+        // libobs releases what the filter returns; the extra reference keeps
+        // the frame with the pipeline
+        out = oldest->out;
+        os_atomic_inc_long(&out->refs);
+    }
+    pthread_mutex_unlock(&mp->mutex);
+
+    if (mp->last_timestamp && timestamp > mp->last_timestamp &&
+        timestamp - mp->last_timestamp < MAX_FRAME_INTERVAL_NS) {
+        const uint64_t interval = timestamp - mp->last_timestamp;
+        mp->interval_ns = mp->interval_ns ? (mp->interval_ns * 7 + interval) / 8 : interval;
+        if (mp->intervals < SETTLED_INTERVALS) mp->intervals++;
+    }
+    mp->last_timestamp = timestamp;
+    return out;
+}
+
+size_t media_pipeline_frames_since(const struct media_pipeline *mp, uint64_t timestamp) {
+    if (!mp->interval_ns || !mp->last_timestamp) return 1;
+    // a source that loops or restarts goes back in time
+    if (timestamp < mp->last_timestamp) return 1;
+    return (size_t)((timestamp - mp->last_timestamp + mp->interval_ns / 2) / mp->interval_ns);
+}
+
+size_t media_pipeline_shown_frame(const struct media_pipeline *mp) {
+    return mp->shown ? mp->shown->frame_num : 0;
+}
+
+uint64_t media_pipeline_interval_ns(const struct media_pipeline *mp) {
+    return mp->intervals < SETTLED_INTERVALS ? 0 : mp->interval_ns;
+}
+
+uint64_t media_pipeline_bytes(const struct media_pipeline *mp) {
+    uint64_t bytes = 0;
+    for (uint32_t i = 0; i < mp->depth; i++) {
+        const struct obs_source_frame *out = mp->slots[i].out;
+        if (out) bytes += (uint64_t)out->linesize[0] * out->height;
+    }
+    return bytes;
+}
@@ -0,0 +1,82 @@
+/*
+ntsc-rs-obs
+Copyright (C) 2025 eigenpunk
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along
+with this program. If not, see <https://www.gnu.org/licenses/>
+*/
+
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include <obs.h>
+
+#include "param-snapshot.h"
+
+// Runs the effect on several frames of an async (media) source at once.
+//
+// libobs hands an async filter each frame just as it's due to be shown, so a
+// filter that processes it there and then has one frame interval for the
+// whole effect, and the worker pool sits partly idle whenever the effect
+// can't use all of it (between stages, on the serial parts of a stage). The
+// pipeline instead queues each frame on one of depth threads and returns the
+// frame queued depth - 1 frames earlier, which has been processed in the
+// meantime. Output lags the source by depth - 1 frames; the filter delays the
+// source's audio to match.
+//
+// Frames are processed in RGBA, BGRA or BGRX. I420, NV12 and I444 frames are
+// converted to RGBA with the frame's color matrix first; other formats can't
+// go through the pipeline.
+
+#define MEDIA_PIPELINE_MAX_DEPTH 8
+
+struct media_pipeline;
+
+// starts depth worker threads; NULL if they couldn't be started
+struct media_pipeline *media_pipeline_create(uint32_t depth);
+
+// Waits for frames being processed and gives back the source frames still
+// queued. The last frame returned by push must no longer be in use by the
+// caller (libobs is done with it once the filter callback returns).
+void media_pipeline_destroy(struct media_pipeline *mp);
+
+uint32_t media_pipeline_depth(const struct media_pipeline *mp);
+
+bool media_pipeline_supports(enum video_format format);
+
+// Queues in, a frame of parent, to be processed with params; the pipeline
+// releases it back to parent once it's been copied. Returns the oldest
+// processed frame once depth frames are in flight, NULL while the pipeline is
+// still filling. The returned frame is reused after the next push unless
+// something else still holds a reference to it. cpu_ns is set to the time it
+// took to process.
+struct obs_source_frame *media_pipeline_push(struct media_pipeline *mp, obs_source_t *parent,
+                                             struct obs_source_frame *in, const struct ntscrs_params *params,
+                                             bool draft, size_t frame_num, uint64_t *cpu_ns);
+
+// How many frame intervals timestamp is past the last pushed frame: 0 for a
+// repeated frame, more than 1 after dropped ones. 1 until the interval is known.
+size_t media_pipeline_frames_since(const struct media_pipeline *mp, uint64_t timestamp);
+
+// effect frame number the frame returned by the last push was processed with
+size_t media_pipeline_shown_frame(const struct media_pipeline *mp);
+
+// average interval between recent frames, 0 until enough of them have been
+// pushed for it to settle; frames come out depth - 1 of these late
+uint64_t media_pipeline_interval_ns(const struct media_pipeline *mp);
+
+// bytes held in processed frames
+uint64_t media_pipeline_bytes(const struct media_pipeline *mp);
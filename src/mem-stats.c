@@ -0,0 +1,56 @@
+/*
+ntsc-rs-obs
+Copyright (C) 2025 eigenpunk
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along
+with this program. If not, see <https://www.gnu.org/licenses/>
+*/
+
+#include <stdio.h>
+
+#include <util/threading.h>
+
+#include <ntscrs.h>
+
+#include "mem-stats.h"
+
+static pthread_mutex_t mem_mutex = PTHREAD_MUTEX_INITIALIZER;
+static struct mem_usage mem_total;
+
+void mem_stats_set(struct mem_usage *instance, const struct mem_usage *usage) {
+    pthread_mutex_lock(&mem_mutex);
+    mem_total.gpu += usage->gpu - instance->gpu;
+    mem_total.system += usage->system - instance->system;
+    *instance = *usage;
+    pthread_mutex_unlock(&mem_mutex);
+}
+
+void mem_stats_get(const struct mem_usage *instance, struct mem_usage *copy, struct mem_usage *total) {
+    pthread_mutex_lock(&mem_mutex);
+    if (instance) *copy = *instance;
+    *total = mem_total;
+    pthread_mutex_unlock(&mem_mutex);
+
+    const struct NtscRsMemoryStats heap = ntscrs_memory_stats();
+    total->heap = heap.current;
+    total->heap_peak = heap.peak;
+}
+
+void mem_stats_format(char *buf, size_t size, const struct mem_usage *usage) {
+    const double mib = 1024.0 * 1024.0;
+    int n = snprintf(buf, size, "%.1f MiB GPU, %.1f MiB system", (double)usage->gpu / mib, (double)usage->system / mib);
+    if (usage->heap_peak && n >= 0 && (size_t)n < size) {
+        snprintf(buf + n, size - (size_t)n, ", %.1f MiB effect heap (peak %.1f MiB)", (double)usage->heap / mib,
+                 (double)usage->heap_peak / mib);
+    }
+}
@@ -0,0 +1,47 @@
+/*
+ntsc-rs-obs
+Copyright (C) 2025 eigenpunk
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along
+with this program. If not, see <https://www.gnu.org/licenses/>
+*/
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Memory each filter instance holds, and the total over all of them, so it's
+// visible how much a setup costs before OBS runs out.
+
+struct mem_usage {
+    uint64_t gpu;    // render target, staging surface, upload textures
+    uint64_t system; // CPU-side frame buffers
+    // Only in the total: the effect library's heap (prepared effects and
+    // per-frame scratch), now and the most it has held at once. Frames of
+    // several filters, media pipelines and benchmarks are processed at the
+    // same time on shared workers, so it can't be split up by filter.
+    uint64_t heap;
+    uint64_t heap_peak;
+};
+
+// Replaces an instance's usage and adjusts the total. Instances start out
+// zeroed and must be set back to zero before they go away. Callable from any
+// thread, as is mem_stats_get.
+void mem_stats_set(struct mem_usage *instance, const struct mem_usage *usage);
+
+// copies an instance's usage (if instance isn't NULL) and the total
+void mem_stats_get(const struct mem_usage *instance, struct mem_usage *copy, struct mem_usage *total);
+
+// "12.3 MiB GPU, 4.5 MiB system", and for a total ", 6.7 MiB effect heap (peak 8.9 MiB)"
+void mem_stats_format(char *buf, size_t size, const struct mem_usage *usage);
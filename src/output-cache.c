@@ -0,0 +1,92 @@
+/*
+ntsc-rs-obs
+Copyright (C) 2025 eigenpunk
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along
+with this program. If not, see <https://www.gnu.org/licenses/>
+*/
+
+#include <string.h>
+
+#include <util/threading.h>
+
+#include "output-cache.h"
+
+// more instances than this sharing one tick just means some won't find an
+// entry and do their own pass
+#define OUTPUT_CACHE_SIZE 16
+
+struct output_cache_entry {
+    struct output_cache_key key;
+    const void *owner; // NULL for an unused entry
+    gs_texture_t *tex;
+    size_t frame;
+};
+
+// filter_destroy can run outside the graphics thread
+static pthread_mutex_t cache_mutex = PTHREAD_MUTEX_INITIALIZER;
+static struct output_cache_entry cache[OUTPUT_CACHE_SIZE];
+
+static inline bool key_equal(const struct output_cache_key *a, const struct output_cache_key *b) {
+    return a->target == b->target && a->params_hash == b->params_hash && a->tick == b->tick && a->cx == b->cx &&
+           a->cy == b->cy && a->format == b->format;
+}
+
+bool output_cache_find(const struct output_cache_key *key, gs_texture_t **tex, size_t *frame) {
+    bool found = false;
+    pthread_mutex_lock(&cache_mutex);
+    for (size_t i = 0; i < OUTPUT_CACHE_SIZE; i++) {
+        const struct output_cache_entry *e = &cache[i];
+        if (e->owner && key_equal(&e->key, key)) {
+            *tex = e->tex;
+            *frame = e->frame;
+            found = true;
+            break;
+        }
+    }
+    pthread_mutex_unlock(&cache_mutex);
+    return found;
+}
+
+void output_cache_publish(const struct output_cache_key *key, const void *owner, gs_texture_t *tex, size_t frame) {
+    pthread_mutex_lock(&cache_mutex);
+
+    // reuse the owner's previous entry, else a free or stale one, else the oldest
+    struct output_cache_entry *slot = NULL;
+    for (size_t i = 0; i < OUTPUT_CACHE_SIZE && !slot; i++) {
+        if (cache[i].owner == owner) slot = &cache[i];
+    }
+    for (size_t i = 0; i < OUTPUT_CACHE_SIZE && !slot; i++) {
+        if (!cache[i].owner || cache[i].key.tick != key->tick) slot = &cache[i];
+    }
+    if (!slot) {
+        slot = &cache[0];
+        for (size_t i = 1; i < OUTPUT_CACHE_SIZE; i++) {
+            if (cache[i].key.tick < slot->key.tick) slot = &cache[i];
+        }
+    }
+
+    slot->key = *key;
+    slot->owner = owner;
+    slot->tex = tex;
+    slot->frame = frame;
+    pthread_mutex_unlock(&cache_mutex);
+}
+
+void output_cache_forget(const void *owner) {
+    pthread_mutex_lock(&cache_mutex);
+    for (size_t i = 0; i < OUTPUT_CACHE_SIZE; i++) {
+        if (cache[i].owner == owner) memset(&cache[i], 0, sizeof(cache[i]));
+    }
+    pthread_mutex_unlock(&cache_mutex);
+}
@@ -0,0 +1,50 @@
+/*
+ntsc-rs-obs
+Copyright (C) 2025 eigenpunk
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along
+with this program. If not, see <https://www.gnu.org/licenses/>
+*/
+
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include <obs-module.h>
+
+// Lets filter instances that would compute the same output in the same
+// video tick share it: the same source below them, the same settings and
+// the same frame size. The first one to render publishes its upload
+// texture; the others draw that texture instead of doing their own readback
+// and effect pass. Entries are only valid for the tick they were made in.
+
+struct output_cache_key {
+    obs_source_t *target;  // first source below the filter
+    uint64_t params_hash;  // everything that affects the output
+    uint64_t tick;         // obs_get_video_frame_time()
+    uint32_t cx, cy;
+    enum gs_color_format format;
+};
+
+// On a hit, *tex is the shared texture and *frame the effect frame number it
+// was made with. tex stays valid for the rest of the current render call.
+// Call from the graphics thread.
+bool output_cache_find(const struct output_cache_key *key, gs_texture_t **tex, size_t *frame);
+
+// Call from the graphics thread, after tex has been written.
+void output_cache_publish(const struct output_cache_key *key, const void *owner, gs_texture_t *tex, size_t frame);
+
+// Drops every entry made by owner; call before its textures are destroyed.
+void output_cache_forget(const void *owner);
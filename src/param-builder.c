@@ -0,0 +1,184 @@
+/*
+ntsc-rs-obs
+Copyright (C) 2025 eigenpunk
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along
+with this program. If not, see <https://www.gnu.org/licenses/>
+*/
+
+#include <string.h>
+
+#include <obs-module.h>
+#include <util/platform.h>
+#include <util/threading.h>
+
+#include "plugin-support.h"
+#include "param-builder.h"
+#include "effect-cache.h"
+
+static pthread_mutex_t builder_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t builder_work = PTHREAD_COND_INITIALIZER;
+static pthread_cond_t builder_done = PTHREAD_COND_INITIALIZER;
+static pthread_t builder_thread;
+static bool builder_running;
+static bool builder_stop;
+
+static struct param_job *queue_head;
+static struct param_job *queue_tail;
+static struct param_job *building;
+
+static uint64_t stats_submitted;
+static uint64_t stats_built;
+
+static inline bool same_output(const struct ntscrs_params *a, const struct ntscrs_params *b) {
+    return a->hash == b->hash && a->quality == b->quality && a->preview_profile == b->preview_profile &&
+           a->incremental == b->incremental && a->paused == b->paused && a->share_output == b->share_output;
+}
+
+// Returns whether anything was published.
+static bool build(struct param_job *job, struct ntscrs_params *params) {
+    // drop stages that are on but set up to do nothing, once per change
+    // rather than every frame
+    const uint32_t pruned = ntscrs_plan_params(&params->ntsc);
+    params->hash = ntscrs_params_hash(params->ntsc);
+    if (job->built && same_output(&job->last, params)) return false;
+
+    if (pruned) obs_log(LOG_DEBUG, "%u enabled stage(s) have no effect with these settings, skipping them", pruned);
+
+    struct ntscrs_param_snapshot *snap = job->snap;
+    const uint64_t generation = snap->staging.generation;
+    snap->staging = *params;
+    snap->staging.generation = generation;
+    snap->staging.effect = effect_cache_acquire(&params->ntsc, params->hash);
+    param_snapshot_publish(snap);
+
+    job->last = *params;
+    job->built = true;
+    return true;
+}
+
+static void *builder_run(void *unused) {
+    UNUSED_PARAMETER(unused);
+    os_set_thread_name("ntscrs-params");
+
+    pthread_mutex_lock(&builder_mutex);
+    for (;;) {
+        while (!queue_head && !builder_stop)
+            pthread_cond_wait(&builder_work, &builder_mutex);
+        if (builder_stop) break;
+
+        struct param_job *job = queue_head;
+        queue_head = job->next;
+        if (!queue_head) queue_tail = NULL;
+        job->next = NULL;
+        job->queued = false;
+
+        struct ntscrs_params params = job->pending;
+        building = job;
+        pthread_mutex_unlock(&builder_mutex);
+
+        const bool published = build(job, &params);
+
+        pthread_mutex_lock(&builder_mutex);
+        if (published) stats_built++;
+        building = NULL;
+        pthread_cond_broadcast(&builder_done);
+    }
+    pthread_mutex_unlock(&builder_mutex);
+    return NULL;
+}
+
+void param_builder_init(void) {
+    pthread_mutex_lock(&builder_mutex);
+    builder_stop = false;
+    builder_running = pthread_create(&builder_thread, NULL, builder_run, NULL) == 0;
+    if (!builder_running) obs_log(LOG_WARNING, "failed to start parameter thread, building on update instead");
+    pthread_mutex_unlock(&builder_mutex);
+}
+
+void param_builder_shutdown(void) {
+    pthread_mutex_lock(&builder_mutex);
+    const bool join = builder_running;
+    builder_stop = true;
+    builder_running = false;
+    pthread_cond_signal(&builder_work);
+    pthread_mutex_unlock(&builder_mutex);
+
+    if (join) pthread_join(builder_thread, NULL);
+}
+
+void param_job_init(struct param_job *job, struct ntscrs_param_snapshot *snap) {
+    memset(job, 0, sizeof(*job));
+    job->snap = snap;
+}
+
+void param_job_submit(struct param_job *job, const struct ntscrs_params *params) {
+    pthread_mutex_lock(&builder_mutex);
+    stats_submitted++;
+
+    if (!job->started || !builder_running) {
+        // nothing of this job is queued or building, so it can be built here
+        job->started = true;
+        pthread_mutex_unlock(&builder_mutex);
+
+        struct ntscrs_params copy = *params;
+        const bool published = build(job, &copy);
+
+        pthread_mutex_lock(&builder_mutex);
+        if (published) stats_built++;
+        pthread_mutex_unlock(&builder_mutex);
+        return;
+    }
+
+    job->pending = *params;
+    if (!job->queued) {
+        job->queued = true;
+        if (queue_tail) {
+            queue_tail->next = job;
+        } else {
+            queue_head = job;
+        }
+        queue_tail = job;
+        pthread_cond_signal(&builder_work);
+    }
+    pthread_mutex_unlock(&builder_mutex);
+}
+
+void param_job_cancel(struct param_job *job) {
+    pthread_mutex_lock(&builder_mutex);
+    if (job->queued) {
+        struct param_job *prev = NULL;
+        for (struct param_job *j = queue_head; j; prev = j, j = j->next) {
+            if (j != job) continue;
+            if (prev) {
+                prev->next = j->next;
+            } else {
+                queue_head = j->next;
+            }
+            if (queue_tail == j) queue_tail = prev;
+            break;
+        }
+        job->queued = false;
+        job->next = NULL;
+    }
+    while (building == job)
+        pthread_cond_wait(&builder_done, &builder_mutex);
+    pthread_mutex_unlock(&builder_mutex);
+}
+
+void param_builder_stats(uint64_t *submitted, uint64_t *built) {
+    pthread_mutex_lock(&builder_mutex);
+    *submitted = stats_submitted;
+    *built = stats_built;
+    pthread_mutex_unlock(&builder_mutex);
+}
@@ -0,0 +1,69 @@
+/*
+ntsc-rs-obs
+Copyright (C) 2025 eigenpunk
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along
+with this program. If not, see <https://www.gnu.org/licenses/>
+*/
+
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "param-snapshot.h"
+
+// Turns parameter sets from filter_update into what the render thread uses
+// (stage plan, hash and a prepared NtscRsEffect) on a background thread and
+// publishes them to the filter's snapshot; rendering carries on with the
+// previous set until then. A set submitted while an older one is still
+// waiting replaces it, so a dragged slider costs one build each time the
+// builder gets to the filter rather than one per update, and a set that comes
+// out the same as the last one built isn't published at all.
+
+struct param_job {
+    struct ntscrs_param_snapshot *snap;
+
+    // submitter only
+    bool started;
+
+    // guarded by the builder
+    struct ntscrs_params pending;
+    bool queued;
+    struct param_job *next;
+
+    // whoever is building
+    struct ntscrs_params last;
+    bool built;
+};
+
+// starts the builder thread; call from obs_module_load
+void param_builder_init(void);
+
+// stops it; call from obs_module_unload, once every filter is gone
+void param_builder_shutdown(void);
+
+// parameter sets for the job get published to snap
+void param_job_init(struct param_job *job, struct ntscrs_param_snapshot *snap);
+
+// Queues a build of params. Submissions for one job must not overlap. The
+// first set is built on the calling thread before returning, so there's
+// something to render from the first frame on.
+void param_job_submit(struct param_job *job, const struct ntscrs_params *params);
+
+// drops a queued build and waits for one in progress; call before freeing
+// the snapshot
+void param_job_cancel(struct param_job *job);
+
+// sets submitted and sets built since load, over all filters
+void param_builder_stats(uint64_t *submitted, uint64_t *built);
@@ -0,0 +1,60 @@
+/*
+ntsc-rs-obs
+Copyright (C) 2025 eigenpunk
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along
+with this program. If not, see <https://www.gnu.org/licenses/>
+*/
+
+#include <string.h>
+
+#include <util/threading.h>
+
+#include "param-snapshot.h"
+#include "effect-cache.h"
+
+#define PARAM_SNAPSHOT_FRESH 0x4
+#define PARAM_SNAPSHOT_INDEX 0x3
+
+void param_snapshot_init(struct ntscrs_param_snapshot *snap) {
+    memset(snap, 0, sizeof(*snap));
+    snap->front = 0;
+    snap->shared = 1;
+    snap->back = 2;
+}
+
+void param_snapshot_free(struct ntscrs_param_snapshot *snap) {
+    for (size_t i = 0; i < 3; i++) {
+        effect_cache_release(snap->slots[i].effect);
+        snap->slots[i].effect = NULL;
+    }
+}
+
+void param_snapshot_publish(struct ntscrs_param_snapshot *snap) {
+    snap->staging.generation++;
+    // the reader never looks at the back slot, so what it held can go
+    effect_cache_release(snap->slots[snap->back].effect);
+    snap->slots[snap->back] = snap->staging;
+    snap->staging.effect = NULL;
+
+    long prev = os_atomic_exchange_long(&snap->shared, snap->back | PARAM_SNAPSHOT_FRESH);
+    snap->back = prev & PARAM_SNAPSHOT_INDEX;
+}
+
+const struct ntscrs_params *param_snapshot_acquire(struct ntscrs_param_snapshot *snap) {
+    if (os_atomic_load_long(&snap->shared) & PARAM_SNAPSHOT_FRESH) {
+        long prev = os_atomic_exchange_long(&snap->shared, snap->front);
+        snap->front = prev & PARAM_SNAPSHOT_INDEX;
+    }
+    return &snap->slots[snap->front];
+}
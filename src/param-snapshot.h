@@ -0,0 +1,84 @@
+/*
+ntsc-rs-obs
+Copyright (C) 2025 eigenpunk
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along
+with this program. If not, see <https://www.gnu.org/licenses/>
+*/
+
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include <ntscrs.h>
+
+enum ntscrs_quality {
+    QUALITY_FULL,
+    QUALITY_DRAFT, // half horizontal resolution for 8-bit frames, see draft.rs
+};
+
+// How to render while the source is only showing (studio mode preview,
+// projectors, multiview) rather than active on program.
+enum ntscrs_preview_profile {
+    PREVIEW_FULL,
+    PREVIEW_DRAFT,
+    PREVIEW_HALF_RATE,
+    PREVIEW_PASSTHROUGH,
+};
+
+// A complete parameter set as seen by the render thread.
+struct ntscrs_params {
+    NtscRsEffectParams ntsc;
+    enum ntscrs_quality quality;
+    enum ntscrs_preview_profile preview_profile;
+    bool incremental;
+    bool paused;
+    bool share_output;
+
+    // ntscrs_params_hash of ntsc
+    uint64_t hash;
+
+    // ntsc prepared for applying, see param-builder.h; the slot holding it
+    // holds a reference from effect-cache.h
+    NtscRsEffect *effect;
+
+    // increments with every publish; 0 means nothing has been published yet
+    uint64_t generation;
+};
+
+// Lock-free handoff of parameter sets from filter_update (one writer) to
+// filter_render (one reader). The writer fills `staging`, then publishes a
+// copy of it with a single atomic swap of slot indices; the reader swaps the
+// latest published slot in when there is one. Neither side ever waits and
+// the reader can never observe a half-written set.
+struct ntscrs_param_snapshot {
+    struct ntscrs_params slots[3];
+    struct ntscrs_params staging;
+
+    volatile long shared; // last published slot, PARAM_SNAPSHOT_FRESH while unread
+    long back;            // slot owned by the writer
+    long front;           // slot owned by the reader
+};
+
+void param_snapshot_init(struct ntscrs_param_snapshot *snap);
+
+// releases the effects held by the slots
+void param_snapshot_free(struct ntscrs_param_snapshot *snap);
+
+// writer side: fill snap->staging, then publish it; the published slot takes
+// over staging.effect
+void param_snapshot_publish(struct ntscrs_param_snapshot *snap);
+
+// reader side: returns the most recently published set
+const struct ntscrs_params *param_snapshot_acquire(struct ntscrs_param_snapshot *snap);
@@ -0,0 +1,182 @@
+/*
+ntsc-rs-obs
+Copyright (C) 2025 eigenpunk
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along
+with this program. If not, see <https://www.gnu.org/licenses/>
+*/
+
+#ifdef __linux__
+#include <errno.h>
+#include <linux/perf_event.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+#include <string.h>
+
+#include <obs-module.h>
+#include <util/threading.h>
+
+#include "plugin-support.h"
+#include "perf-counters.h"
+
+// Counters are kept per worker index. A resized or recreated pool's workers
+// take over the slots of the ones they replace and close their counters, which
+// have nothing left to count once the old pool's last frame is done.
+#define PERF_MAX_THREADS 256
+
+struct perf_thread {
+    int fd[PERF_COUNTERS]; // the group leader first
+    uint32_t n;
+    enum perf_counter kind[PERF_COUNTERS]; // in the order the group reads them
+};
+
+static bool enabled;
+static pthread_mutex_t threads_mutex = PTHREAD_MUTEX_INITIALIZER;
+static struct perf_thread threads[PERF_MAX_THREADS];
+static size_t thread_count;
+static volatile long available;
+static volatile bool reported;
+
+void perf_counters_enable(void) {
+#ifdef __linux__
+    enabled = true;
+#else
+    obs_log(LOG_WARNING, "perf counters: only available on Linux");
+#endif
+}
+
+bool perf_counters_enabled(void) {
+    return enabled && os_atomic_load_long(&available) != 0;
+}
+
+#ifdef __linux__
+static const struct {
+    const char *name;
+    uint64_t config;
+} counters[PERF_COUNTERS] = {
+    [PERF_CYCLES] = {"cycles", PERF_COUNT_HW_CPU_CYCLES},
+    [PERF_INSTRUCTIONS] = {"instructions", PERF_COUNT_HW_INSTRUCTIONS},
+    // the generic cache miss event is last-level misses on x86 and most ARM
+    [PERF_LLC_MISSES] = {"LLC misses", PERF_COUNT_HW_CACHE_MISSES},
+    [PERF_BRANCH_MISSES] = {"branch misses", PERF_COUNT_HW_BRANCH_MISSES},
+};
+
+static int open_counter(uint64_t config, int group) {
+    struct perf_event_attr attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = PERF_TYPE_HARDWARE;
+    attr.config = config;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    attr.read_format = PERF_FORMAT_GROUP | PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+    return (int)syscall(SYS_perf_event_open, &attr, 0, -1, group, 0);
+}
+#endif
+
+void perf_counters_thread_start(size_t index) {
+#ifdef __linux__
+    if (!enabled || index >= PERF_MAX_THREADS) return;
+
+    struct perf_thread t = {.n = 0};
+    int err = 0;
+    long mask = 0;
+    for (int c = 0; c < PERF_COUNTERS; c++) {
+        const int fd = open_counter(counters[c].config, t.n ? t.fd[0] : -1);
+        if (fd < 0) {
+            err = errno;
+            continue;
+        }
+        // members are read through the leader
+        t.fd[t.n] = fd;
+        t.kind[t.n++] = (enum perf_counter)c;
+        mask |= 1L << c;
+    }
+
+    if (!os_atomic_set_bool(&reported, true)) {
+        if (!mask) {
+            // EACCES/EPERM is perf_event_paranoid, ENOENT a CPU or VM without counters
+            obs_log(LOG_WARNING, "perf counters: unavailable (%s)", strerror(err));
+        } else {
+            char names[128] = "";
+            for (int c = 0; c < PERF_COUNTERS; c++) {
+                if (!(mask & (1L << c))) continue;
+                if (names[0]) strncat(names, ", ", sizeof(names) - strlen(names) - 1);
+                strncat(names, counters[c].name, sizeof(names) - strlen(names) - 1);
+            }
+            obs_log(LOG_INFO, "perf counters: counting %s on the effect's workers", names);
+        }
+    }
+
+    long old = os_atomic_load_long(&available);
+    while (!os_atomic_compare_exchange_long(&available, &old, old | mask))
+        ;
+
+    pthread_mutex_lock(&threads_mutex);
+    struct perf_thread *slot = &threads[index];
+    if (index >= thread_count) {
+        thread_count = index + 1;
+    } else {
+        for (uint32_t i = 0; i < slot->n; i++)
+            close(slot->fd[i]);
+    }
+    *slot = t;
+    pthread_mutex_unlock(&threads_mutex);
+#else
+    UNUSED_PARAMETER(index);
+#endif
+}
+
+bool perf_counters_read(struct perf_sample *sample) {
+    memset(sample, 0, sizeof(*sample));
+    if (!perf_counters_enabled()) return false;
+
+#ifdef __linux__
+    pthread_mutex_lock(&threads_mutex);
+    for (size_t i = 0; i < thread_count; i++) {
+        const struct perf_thread *t = &threads[i];
+        if (!t->n) continue;
+
+        // nr, time enabled, time running, then one value per counter
+        uint64_t buf[3 + PERF_COUNTERS];
+        if (read(t->fd[0], buf, sizeof(buf)) < (ssize_t)(3 * sizeof(uint64_t))) continue;
+        const uint64_t time_enabled = buf[1], time_running = buf[2];
+        for (uint64_t k = 0; k < buf[0] && k < t->n; k++) {
+            uint64_t value = buf[3 + k];
+            if (time_running && time_running < time_enabled)
+                value = (uint64_t)((double)value * time_enabled / time_running);
+            sample->value[t->kind[k]] += value;
+        }
+    }
+    pthread_mutex_unlock(&threads_mutex);
+    sample->available = (uint32_t)os_atomic_load_long(&available);
+    return true;
+#else
+    return false;
+#endif
+}
+
+void perf_sample_delta(struct perf_sample *out, const struct perf_sample *after, const struct perf_sample *before) {
+    for (int c = 0; c < PERF_COUNTERS; c++) {
+        out->value[c] = after->value[c] > before->value[c] ? after->value[c] - before->value[c] : 0;
+    }
+    out->available = after->available;
+}
+
+void perf_sample_add(struct perf_sample *sum, const struct perf_sample *s) {
+    for (int c = 0; c < PERF_COUNTERS; c++)
+        sum->value[c] += s->value[c];
+    sum->available |= s->available;
+}
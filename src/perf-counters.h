@@ -0,0 +1,64 @@
+/*
+ntsc-rs-obs
+Copyright (C) 2025 eigenpunk
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along
+with this program. If not, see <https://www.gnu.org/licenses/>
+*/
+
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// Hardware counters for the effect's worker threads, for telling whether it's
+// held up by memory bandwidth, cache misses or compute, and for checking that
+// a layout change did what it was meant to. Opt-in ("perf_counters" in
+// workers.json) and Linux only; elsewhere, or where perf_event_open is
+// refused (perf_event_paranoid above 2, containers, VMs without a virtual
+// PMU), nothing is counted and reads fail.
+//
+// Each worker opens counters for itself as it starts, user space only. The
+// workers do nothing but run the effect, so the change over a frame is that
+// frame's cost, plus that of any other filter processing at the same time.
+
+enum perf_counter {
+    PERF_CYCLES,
+    PERF_INSTRUCTIONS,
+    PERF_LLC_MISSES,
+    PERF_BRANCH_MISSES,
+    PERF_COUNTERS,
+};
+
+struct perf_sample {
+    uint64_t value[PERF_COUNTERS];
+    // bit per counter that at least one worker could open
+    uint32_t available;
+};
+
+// call from workers_init before the worker pool is recreated
+void perf_counters_enable(void);
+bool perf_counters_enabled(void);
+
+// Opens the calling thread's counters; call on each worker as it starts, with
+// its index in the pool. Closes those of the worker it replaces.
+void perf_counters_thread_start(size_t index);
+
+// Sums every worker's counters so far, scaled up for any time the kernel had
+// them multiplexed out. Returns false if nothing is being counted.
+bool perf_counters_read(struct perf_sample *sample);
+
+// after - before, for each counter
+void perf_sample_delta(struct perf_sample *out, const struct perf_sample *after, const struct perf_sample *before);
+void perf_sample_add(struct perf_sample *sum, const struct perf_sample *s);
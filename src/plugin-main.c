@@ -16,10 +16,28 @@ You should have received a copy of the GNU General Public License along
 with this program. If not, see <https://www.gnu.org/licenses/>
 */
 
+#include <errno.h>
+
 #include <obs-module.h>
+#include <util/platform.h>
+#include <util/threading.h>
 
 #include "plugin-support.h"
 #include "plugin-props.h"
+#include "param-snapshot.h"
+#include "param-builder.h"
+#include "dirty-rows.h"
+#include "trace.h"
+#include "autotune.h"
+#include "upload-ring.h"
+#include "output-cache.h"
+#include "workers.h"
+#include "mem-stats.h"
+#include "effect-cache.h"
+#include "media-pipeline.h"
+#include "perf-counters.h"
+#include "frame-pool.h"
+#include "shm-ring.h"
 
 OBS_DECLARE_MODULE()
 OBS_MODULE_USE_DEFAULT_LOCALE(PLUGIN_NAME, "en-US")
@@ -30,13 +48,29 @@ OBS_MODULE_USE_DEFAULT_LOCALE(PLUGIN_NAME, "en-US")
 #define OUTPUT_WIDTH (fd->cx)
 #define OUTPUT_HEIGHT (fd->cy)
 
+#define NTSCRS_FILTER_ID "ntsc_rs_filter"
+#define NTSCRS_MEDIA_FILTER_ID "ntsc_rs_media_filter"
+#define MAX_FUSED_FILTERS 8
+#define MAX_DIRTY_BANDS 16
+
+// frames a reader can fall behind the shared-memory ring before losing them
+#define SHM_SLOTS 4
+
+// length of the window effect CPU use is reported over
+#define STATS_WINDOW_NS 10000000000ULL
+
+// frames the media filter's frame rate has to stay more than 10% off before
+// the audio delay follows it
+#define MEDIA_RELATCH_FRAMES 16
+
 struct ntscrs_filter_data {
     obs_source_t* context;
 
     gs_texrender_t *texrender;
     gs_stagesurf_t *stagesurf;
     uint8_t *framebuf;
-    gs_texture_t *framebuf_tex;
+    size_t framebuf_size;
+    struct upload_ring upload;
 
     enum gs_color_space space;
     enum gs_color_format format;
@@ -45,9 +79,81 @@ struct ntscrs_filter_data {
 
     bool frame_processed;
 
-    NtscRsEffectParams ntsc;
+    // last time the filter rendered or got a media frame; buffers are
+    // released once this is older than workers_idle_release_ns
+    uint64_t last_used_ns;
+
+    // filter_update's copy of the settings, which keeps the values of
+    // disabled stages around
+    struct ntscrs_params settings;
+
+    // built from settings by the parameter builder, read by filter_render
+    struct param_job param_job;
+    struct ntscrs_param_snapshot params;
+    uint64_t params_generation;
     size_t frame;
-    bool paused;
+
+    // previous input/output for incremental processing
+    struct dirty_rows dirty;
+
+    // what this instance holds, see mem-stats.h
+    struct mem_usage mem;
+
+    // whether the upload ring holds a processed frame yet
+    bool has_output;
+
+    // effect CPU use in the current window; the last complete window is kept
+    // for the properties view, which reads it from the UI thread
+    uint64_t stats_window_start;
+    uint64_t stats_cpu_ns;
+    uint32_t stats_processed;
+    uint32_t stats_reused;
+    volatile long stats_last_cpu_permille;
+    volatile long stats_last_processed;
+    volatile long stats_last_reused;
+
+    // hardware counters over the current window, when enabled in workers.json
+    struct perf_sample stats_perf;
+    uint64_t stats_pixels;
+
+    // drawing another instance's output this tick instead of our own
+    bool shared;
+    struct output_cache_key shared_key;
+
+    // preview-only state, see enum ntscrs_preview_profile
+    bool preview;
+    bool preview_skip_next;
+
+    // trace capture; settings are written by filter_update, the writer is
+    // only touched by the render thread
+    pthread_mutex_t trace_mutex;
+    char *trace_path;
+    uint32_t trace_frames;
+    bool trace_compress;
+    volatile bool trace_requested;
+    struct ntscrs_trace_writer *trace;
+    uint32_t trace_remaining;
+
+    // shared-memory output, see shm-ring.h; the name is written by
+    // filter_update, the writer belongs to the thread processing frames
+    pthread_mutex_t shm_mutex;
+    char *shm_name;
+    volatile bool shm_enabled;
+    volatile long shm_changes;
+    long shm_seen_changes;
+    bool shm_tried;
+    struct ntscrs_shm_writer *shm;
+
+    // media filter only, see media-pipeline.h; the depth is written by
+    // filter_update, the latched frame interval by filter_media_video, and
+    // both are read by filter_media_audio on the audio thread; the rest
+    // belongs to filter_media_video
+    struct media_pipeline *media;
+    volatile long media_depth;
+    volatile long media_interval_ns;
+    uint32_t media_interval_off;
+    uint64_t media_bytes;
+    bool media_format_warned;
 };
 
 static const char* filter_getname(void* unused) {
@@ -55,8 +161,32 @@ static const char* filter_getname(void* unused) {
     return "ntsc-rs";
 }
 
+static const char *filter_media_getname(void *unused) {
+    UNUSED_PARAMETER(unused);
+    return "ntsc-rs (media sources)";
+}
+
+// Recomputes what this instance holds; call whenever a buffer is allocated
+// or freed.
+static void account_memory(struct ntscrs_filter_data *fd) {
+    const uint64_t frame = (uint64_t)fd->cx * fd->cy * (gs_get_format_bpp(fd->format) / 8);
+    struct mem_usage usage = {0};
+
+    if (fd->texrender) usage.gpu += frame;
+    if (fd->stagesurf) usage.gpu += frame;
+    usage.gpu += frame * fd->upload.count;
+
+    usage.system += fd->framebuf_size;
+    // previous input, previous output and band scratch
+    if (fd->dirty.prev_in) usage.system += 3 * (uint64_t)fd->dirty.linesize * fd->dirty.height;
+    usage.system += fd->media_bytes;
+
+    mem_stats_set(&fd->mem, &usage);
+}
+
 static inline void make_textures(struct ntscrs_filter_data *fd, enum gs_color_format format) {
     if (!fd) return;
+    fd->format = format;
 
     if (!fd->texrender) {
         obs_enter_graphics();
@@ -71,38 +201,52 @@ static inline void make_textures(struct ntscrs_filter_data *fd, enum gs_color_fo
     }
 
     if (!fd->framebuf) {
-        const size_t stride = gs_get_format_bpp(format);
-        fd->framebuf = bzalloc(stride * OUTPUT_WIDTH * OUTPUT_HEIGHT);
+        // gs_get_format_bpp is in bits
+        const size_t stride = gs_get_format_bpp(format) / 8;
+        fd->framebuf_size = stride * OUTPUT_WIDTH * OUTPUT_HEIGHT;
+        fd->framebuf = frame_pool_get(fd->framebuf_size);
     }
 
-    if (!fd->framebuf_tex) {
+    if (!fd->upload.count) {
         obs_enter_graphics();
-        fd->framebuf_tex = gs_texture_create(OUTPUT_WIDTH, OUTPUT_HEIGHT, format, 1, NULL, GS_DYNAMIC);
+        upload_ring_create(&fd->upload, OUTPUT_WIDTH, OUTPUT_HEIGHT, format);
         obs_leave_graphics();
     }
+
+    account_memory(fd);
 }
 
 static void* filter_create(obs_data_t* settings, obs_source_t* context) {
     struct ntscrs_filter_data *fd = bzalloc(sizeof(struct ntscrs_filter_data));
     fd->context = context;
+    pthread_mutex_init(&fd->trace_mutex, NULL);
+    pthread_mutex_init(&fd->shm_mutex, NULL);
+    param_snapshot_init(&fd->params);
+    param_job_init(&fd->param_job, &fd->params);
     obs_source_update(context, settings);
+    autotune_first_use();
     return fd;
 }
 
 static inline void free_textures(struct ntscrs_filter_data *fd) {
     if (!fd) return;
 
-    if (fd->framebuf_tex) {
+    output_cache_forget(fd);
+    fd->shared = false;
+    fd->has_output = false;
+
+    if (fd->upload.count) {
         obs_enter_graphics();
-        gs_texture_destroy(fd->framebuf_tex);
+        upload_ring_destroy(&fd->upload);
         obs_leave_graphics();
-        fd->framebuf_tex = NULL;
     }
 
-    if (fd->framebuf) {
-        bfree(fd->framebuf);
-        fd->framebuf = NULL;
-    }
+    // another filter may show up wanting the same size
+    frame_pool_put(fd->framebuf, fd->framebuf_size);
+    fd->framebuf = NULL;
+    fd->framebuf_size = 0;
+
+    dirty_rows_free(&fd->dirty);
 
     if (fd->stagesurf) {
         obs_enter_graphics();
@@ -117,21 +261,135 @@ static inline void free_textures(struct ntscrs_filter_data *fd) {
         obs_leave_graphics();
         fd->texrender = NULL;
     }
+
+    account_memory(fd);
+}
+
+static void trace_capture_stop(struct ntscrs_filter_data *fd) {
+    if (!fd->trace) return;
+
+    const uint64_t n = ntscrs_trace_writer_frame_count(fd->trace);
+    if (ntscrs_trace_writer_close(fd->trace)) {
+        obs_log(LOG_INFO, "trace capture finished, %llu frames written", (unsigned long long)n);
+    } else {
+        obs_log(LOG_ERROR, "trace capture failed to finalize file");
+    }
+    fd->trace = NULL;
+    fd->trace_remaining = 0;
+}
+
+static void trace_capture_start(struct ntscrs_filter_data *fd, NtscRsPixelFormat pix_fmt, uint32_t bytes_per_pixel) {
+    trace_capture_stop(fd);
+
+    pthread_mutex_lock(&fd->trace_mutex);
+    const bool have_path = fd->trace_path && *fd->trace_path;
+    FILE *file = have_path ? os_fopen(fd->trace_path, "wb") : NULL;
+    if (file) {
+        fd->trace = ntscrs_trace_writer_create(file, fd->cx, fd->cy, pix_fmt, bytes_per_pixel, fd->trace_compress);
+        fd->trace_remaining = fd->trace_frames;
+        obs_log(LOG_INFO, "trace capture started: %u frames to '%s'", fd->trace_frames, fd->trace_path);
+    } else {
+        obs_log(LOG_ERROR, "trace capture: cannot open '%s'", have_path ? fd->trace_path : "");
+    }
+    pthread_mutex_unlock(&fd->trace_mutex);
+}
+
+// Records the frame about to be processed with this filter's own parameters.
+// Writes are synchronous, which is acceptable for an explicit capture.
+static void trace_capture_frame(struct ntscrs_filter_data *fd, const struct ntscrs_params *params,
+                                NtscRsPixelFormat pix_fmt, uint32_t bytes_per_pixel) {
+    if (os_atomic_exchange_bool(&fd->trace_requested, false)) {
+        trace_capture_start(fd, pix_fmt, bytes_per_pixel);
+    }
+    if (!fd->trace) return;
+
+    const size_t size = (size_t)fd->cx * fd->cy * bytes_per_pixel;
+    if (!ntscrs_trace_write_frame(fd->trace, &params->ntsc, fd->frame, fd->framebuf, size)) {
+        obs_log(LOG_ERROR, "trace capture: write failed, stopping");
+        trace_capture_stop(fd);
+        return;
+    }
+    if (--fd->trace_remaining == 0) {
+        trace_capture_stop(fd);
+    }
+}
+
+// Copies a processed frame into the filter's shared-memory ring, making the
+// ring first if a name was set or the frame size or format changed.
+static void shm_publish(struct ntscrs_filter_data *fd, const uint8_t *data, size_t linesize, uint32_t cx,
+                        uint32_t cy, NtscRsPixelFormat pix_fmt, uint32_t bytes_per_pixel, size_t frame) {
+    const long changes = os_atomic_load_long(&fd->shm_changes);
+    if (changes != fd->shm_seen_changes || (fd->shm && !ntscrs_shm_writer_fits(fd->shm, cx, cy, pix_fmt))) {
+        ntscrs_shm_writer_destroy(fd->shm);
+        fd->shm = NULL;
+        fd->shm_seen_changes = changes;
+        fd->shm_tried = false;
+    }
+
+    if (!fd->shm_tried) {
+        fd->shm_tried = true;
+        pthread_mutex_lock(&fd->shm_mutex);
+        if (fd->shm_name && *fd->shm_name) {
+            errno = 0;
+            fd->shm = ntscrs_shm_writer_create(fd->shm_name, cx, cy, pix_fmt, bytes_per_pixel, SHM_SLOTS);
+            if (fd->shm) {
+                obs_log(LOG_INFO, "publishing %ux%u output to shared memory '%s'", cx, cy, fd->shm_name);
+            } else if (errno == EEXIST) {
+                obs_log(LOG_WARNING, "shared memory '%s' is taken by something other than ntsc-rs; not replacing it",
+                        fd->shm_name);
+            } else {
+                obs_log(LOG_WARNING, "could not create shared memory '%s'", fd->shm_name);
+            }
+        }
+        pthread_mutex_unlock(&fd->shm_mutex);
+    }
+
+    if (fd->shm) ntscrs_shm_publish(fd->shm, data, linesize, frame);
 }
 
 static void filter_destroy(void* data) {
     struct ntscrs_filter_data *fd = data;
     if (fd) {
+        trace_capture_stop(fd);
         free_textures(fd);
+        media_pipeline_destroy(fd->media);
+        param_job_cancel(&fd->param_job);
+        param_snapshot_free(&fd->params);
+        pthread_mutex_destroy(&fd->trace_mutex);
+        bfree(fd->trace_path);
+        ntscrs_shm_writer_destroy(fd->shm);
+        pthread_mutex_destroy(&fd->shm_mutex);
+        bfree(fd->shm_name);
         bfree(fd);
     }
 }
 
+// Gives back what a filter that hasn't been rendered (or, for the media
+// filter, fed frames) for a while holds: scenes that aren't shown otherwise
+// keep full-size textures and buffers around indefinitely. Everything is made
+// again on the next render, which still processes that frame.
+static void release_if_idle(struct ntscrs_filter_data *fd) {
+    const uint64_t idle_ns = workers_idle_release_ns();
+    if (!idle_ns || !(fd->texrender || fd->framebuf || fd->upload.count || fd->media)) return;
+    if (os_gettime_ns() - fd->last_used_ns < idle_ns) return;
+
+    free_textures(fd);
+    if (fd->media) {
+        media_pipeline_destroy(fd->media);
+        fd->media = NULL;
+        fd->media_bytes = 0;
+        account_memory(fd);
+    }
+    obs_log(LOG_INFO, "idle for %llu s, released textures and buffers",
+            (unsigned long long)(idle_ns / 1000000000ULL));
+}
+
 static void filter_tick(void *data, float t) {
     UNUSED_PARAMETER(t);
     struct ntscrs_filter_data *fd = data;
 
     fd->frame_processed = false;
+    release_if_idle(fd);
 }
 
 static const char *
@@ -184,8 +442,12 @@ get_tech_name_and_multiplier(enum gs_color_space current_space,
 }
 
 static void draw_frame(struct ntscrs_filter_data *fd) {
-    if (!fd->framebuf_tex) return;
-    gs_texture_t *tex = fd->framebuf_tex;
+    gs_texture_t *tex = NULL;
+    size_t frame;
+    if (!fd->shared || !output_cache_find(&fd->shared_key, &tex, &frame)) {
+        tex = upload_ring_current(&fd->upload);
+    }
+    if (!tex) return;
 
     const enum gs_color_space current_space = gs_get_color_space();
     float multiplier;
@@ -199,9 +461,156 @@ static void draw_frame(struct ntscrs_filter_data *fd) {
     }
 }
 
+// Walks down the filter chain starting at target and collects every directly
+// adjacent ntsc-rs filter, so that the whole run can share one readback and
+// one upload. Disabled filters of any kind are stepped over since they pass
+// their input through untouched. Returns the number of collected filters,
+// nearest first; *render_target is set to the first source below the run.
+static size_t collect_fused_filters(obs_source_t *target, struct ntscrs_filter_data **fused, obs_source_t **render_target) {
+    size_t n = 0;
+    obs_source_t *src = target;
+    obs_source_t *next;
+
+    while (n < MAX_FUSED_FILTERS && (next = obs_filter_get_target(src)) != NULL) {
+        if (obs_source_enabled(src)) {
+            const char *id = obs_source_get_id(src);
+            if (!id || strcmp(id, NTSCRS_FILTER_ID) != 0) break;
+
+            struct ntscrs_filter_data *child = obs_obj_get_data(src);
+            if (!child) break;
+            fused[n++] = child;
+        }
+        src = next;
+    }
+
+    *render_target = src;
+    return n;
+}
+
+static inline bool use_draft(const struct ntscrs_params *params, bool preview) {
+    return params->quality == QUALITY_DRAFT || (preview && params->preview_profile == PREVIEW_DRAFT);
+}
+
+static inline void apply_effect(const struct ntscrs_params *params, bool preview, uint8_t *buf, uint32_t cx,
+                                uint32_t cy, NtscRsPixelFormat pix_fmt, size_t frame) {
+    if (use_draft(params, preview)) {
+        ntscrs_effect_apply_draft(params->effect, cx, cy, buf, pix_fmt, frame);
+    } else {
+        ntscrs_effect_apply(params->effect, cx, cy, buf, pix_fmt, frame);
+    }
+}
+
+// Runs the effect only on the rows that changed since the previous frame (plus
+// the rows around them that vertical stages let the change reach) and reuses
+// the previous output for the rest. The effect's frame number is held at the
+// value of the last full pass so that reused and re-run rows match. Returns
+// the buffer holding the complete output, or NULL if incremental processing
+// isn't possible right now.
+static const uint8_t *apply_effect_incremental(struct ntscrs_filter_data *fd, const struct ntscrs_params *params,
+                                               bool preview, NtscRsPixelFormat pix_fmt, uint32_t bytes_per_pixel) {
+    struct dirty_rows *dr = &fd->dirty;
+    const size_t linesize = (size_t)fd->cx * bytes_per_pixel;
+    const uint8_t *prev_buffer = dr->prev_in;
+    if (!dirty_rows_resize(dr, linesize, fd->cy)) return NULL;
+    if (dr->prev_in != prev_buffer) account_memory(fd);
+
+    struct dirty_band bands[MAX_DIRTY_BANDS];
+    // preview and program may differ in draft, and reused rows must match
+    // the path the re-run ones take
+    const bool draft = use_draft(params, preview);
+    size_t n = DIRTY_ROWS_ALL;
+    if (dr->valid && dr->generation == params->generation && dr->draft == draft) {
+        n = dirty_rows_find(dr, fd->framebuf, dirty_rows_halo(&params->ntsc), bands, MAX_DIRTY_BANDS);
+    }
+
+    if (n == DIRTY_ROWS_ALL) {
+        dirty_rows_apply_full(dr, fd->framebuf, params->effect, draft, fd->cx, pix_fmt, fd->frame);
+        dr->generation = params->generation;
+        return dr->out;
+    }
+    return dirty_rows_apply_bands(dr, fd->framebuf, bands, n, params->effect, draft, fd->cx, pix_fmt);
+}
+
+// Identifies this tick's output for sharing between instances. Draft, pause
+// and incremental processing change the output without being effect settings.
+// Paused filters only share with ones frozen at the same frame.
+static void output_key(struct output_cache_key *key, obs_source_t *render_target, const struct ntscrs_params *params,
+                       bool preview, size_t frame, uint32_t cx, uint32_t cy, enum gs_color_format format) {
+    const uint64_t flags = (uint64_t)use_draft(params, preview) | (uint64_t)params->paused << 1 |
+                           (uint64_t)params->incremental << 2;
+
+    key->target = render_target;
+    key->params_hash = params->hash ^ (flags * 0x9e3779b97f4a7c15ULL);
+    if (params->paused) key->params_hash ^= ((uint64_t)frame + 1) * 0xc2b2ae3d27d4eb4fULL;
+    key->tick = obs_get_video_frame_time();
+    key->cx = cx;
+    key->cy = cy;
+    key->format = format;
+}
+
+// appends " name value" for a counter per pixel, or "name n/a"
+static void append_per_pixel(char *buf, size_t size, const struct perf_sample *perf, enum perf_counter c,
+                             uint64_t pixels, const char *name) {
+    const size_t len = strlen(buf);
+    if (perf->available & (1u << c)) {
+        snprintf(buf + len, size - len, ", %.3f %s", (double)perf->value[c] / (double)pixels, name);
+    } else {
+        snprintf(buf + len, size - len, ", %s n/a", name);
+    }
+}
+
+static void log_perf(const struct perf_sample *perf, uint64_t pixels) {
+    char text[256];
+    const bool have_ipc = (perf->available & (1u << PERF_CYCLES)) && (perf->available & (1u << PERF_INSTRUCTIONS));
+    if (have_ipc && perf->value[PERF_CYCLES]) {
+        snprintf(text, sizeof(text), "%.2f IPC", (double)perf->value[PERF_INSTRUCTIONS] / perf->value[PERF_CYCLES]);
+    } else {
+        snprintf(text, sizeof(text), "IPC n/a");
+    }
+    append_per_pixel(text, sizeof(text), perf, PERF_CYCLES, pixels, "cycles");
+    append_per_pixel(text, sizeof(text), perf, PERF_LLC_MISSES, pixels, "LLC misses");
+    append_per_pixel(text, sizeof(text), perf, PERF_BRANCH_MISSES, pixels, "branch misses");
+    obs_log(LOG_INFO, "effect counters: %s per pixel", text);
+}
+
+// Accounts one tick of this filter's effect CPU use, and logs and keeps the
+// totals whenever a window is complete.
+static void stats_frame(struct ntscrs_filter_data *fd, uint64_t cpu_ns, bool reused) {
+    const uint64_t now = os_gettime_ns();
+    if (!fd->stats_window_start) fd->stats_window_start = now;
+
+    fd->stats_cpu_ns += cpu_ns;
+    if (reused) {
+        fd->stats_reused++;
+    } else {
+        fd->stats_processed++;
+    }
+
+    const uint64_t elapsed = now - fd->stats_window_start;
+    if (elapsed < STATS_WINDOW_NS) return;
+
+    const long permille = (long)(fd->stats_cpu_ns * 1000 / elapsed);
+    os_atomic_set_long(&fd->stats_last_cpu_permille, permille);
+    os_atomic_set_long(&fd->stats_last_processed, (long)fd->stats_processed);
+    os_atomic_set_long(&fd->stats_last_reused, (long)fd->stats_reused);
+    obs_log(fd->stats_reused ? LOG_INFO : LOG_DEBUG,
+            "effect CPU use %.1f%% of one core, %u frames processed, %u reused to stay within the budget",
+            permille / 10.0, fd->stats_processed, fd->stats_reused);
+
+    if (fd->stats_pixels) log_perf(&fd->stats_perf, fd->stats_pixels);
+
+    fd->stats_window_start = now;
+    fd->stats_cpu_ns = 0;
+    fd->stats_processed = 0;
+    fd->stats_reused = 0;
+    memset(&fd->stats_perf, 0, sizeof(fd->stats_perf));
+    fd->stats_pixels = 0;
+}
+
 static void filter_render(void* data, gs_effect_t *effect) {
     UNUSED_PARAMETER(effect);
     struct ntscrs_filter_data *fd = data;
+    fd->last_used_ns = os_gettime_ns();
 
     // get/validate source target/parent
     obs_source_t *target, *parent;
@@ -216,9 +625,15 @@ static void filter_render(void* data, gs_effect_t *effect) {
         return;
     }
 
+    // fuse with any ntsc-rs filters directly below this one; those are not
+    // rendered on their own, so everything below is queried from render_target
+    struct ntscrs_filter_data *fused[MAX_FUSED_FILTERS];
+    obs_source_t *render_target;
+    const size_t n_fused = collect_fused_filters(target, fused, &render_target);
+
     // validate target dimensions
-    uint32_t cx = obs_source_get_width(target),
-             cy = obs_source_get_height(target);
+    uint32_t cx = obs_source_get_width(render_target),
+             cy = obs_source_get_height(render_target);
     if (cx <= 0 || cy <= 0) {
         obs_log(LOG_ERROR, "target has invalid size %dx%d (one or more dims <= 0)", cx, cy);
         obs_source_skip_video_filter(fd->context);
@@ -230,33 +645,126 @@ static void filter_render(void* data, gs_effect_t *effect) {
         GS_CS_SRGB_16F,
         GS_CS_709_EXTENDED,
     };
-    const enum gs_color_space space = obs_source_get_color_space(target, OBS_COUNTOF(preferred_spaces), preferred_spaces);
+    const enum gs_color_space space = obs_source_get_color_space(render_target, OBS_COUNTOF(preferred_spaces), preferred_spaces);
     const enum gs_color_format format = gs_get_format_from_space(space);
     const enum gs_color_format tr_fmt = fd->texrender ? gs_texrender_get_format(fd->texrender) : GS_UNKNOWN;
 
     if (cx != fd->cx || cy != fd->cy || tr_fmt != format) {
+        // a trace can't change frame size midway
+        trace_capture_stop(fd);
+
         fd->cx = cx;
         fd->cy = cy;
         fd->space = space;
 
         free_textures(fd);
         make_textures(fd, format);
-        obs_log(LOG_INFO, "created/resized textures, size %ux%u", cx, cy);
 
-        obs_source_skip_video_filter(fd->context);
-        return;
+        struct mem_usage own, total;
+        char own_text[128], total_text[128];
+        mem_stats_get(&fd->mem, &own, &total);
+        mem_stats_format(own_text, sizeof(own_text), &own);
+        mem_stats_format(total_text, sizeof(total_text), &total);
+        obs_log(LOG_INFO, "created/resized textures, size %ux%u; holding %s (all filters: %s)", cx, cy, own_text,
+                total_text);
     }
-    if (fd->framebuf_tex == NULL || fd->framebuf == NULL || fd->texrender == NULL || fd->stagesurf == NULL) {
+    if (fd->upload.count == 0 || fd->framebuf == NULL || fd->texrender == NULL || fd->stagesurf == NULL) {
         obs_source_skip_video_filter(fd->context);
         return;
     }
 
+    // fused filters report their size through us and don't need their own textures
+    for (size_t i = 0; i < n_fused; i++) {
+        struct ntscrs_filter_data *child = fused[i];
+        child->cx = cx;
+        child->cy = cy;
+        child->space = space;
+        if (child->texrender) {
+            free_textures(child);
+            obs_log(LOG_INFO, "fused into filter above, released own textures");
+        }
+    }
+
     // early out if we've already handled this frame
     if (fd->frame_processed) {
         draw_frame(fd);
         return;
     }
 
+    const struct ntscrs_params *params = param_snapshot_acquire(&fd->params);
+    if (params->generation == 0) {
+        obs_source_skip_video_filter(fd->context);
+        return;
+    }
+    if (params->generation != fd->params_generation) {
+        obs_log(LOG_DEBUG, "picked up parameter set %llu", (unsigned long long)params->generation);
+        fd->params_generation = params->generation;
+    }
+
+    // full quality whenever the source is on program; only showing means
+    // preview, projectors or multiview, where a cheaper profile may apply
+    const bool preview = !obs_source_active(parent);
+    if (preview != fd->preview) {
+        obs_log(LOG_DEBUG, "switched to %s profile", preview ? "preview" : "program");
+        fd->preview = preview;
+        fd->preview_skip_next = false;
+    }
+    if (preview && params->preview_profile == PREVIEW_PASSTHROUGH) {
+        obs_source_skip_video_filter(fd->context);
+        return;
+    }
+
+    // another instance on the same source with the same settings may have
+    // made this tick's output already; fused runs, traces and filters
+    // publishing to shared memory don't take part
+    struct output_cache_key key;
+    const bool share = params->share_output && n_fused == 0 && !fd->trace &&
+                       !os_atomic_load_bool(&fd->trace_requested) && !os_atomic_load_bool(&fd->shm_enabled);
+    if (share) {
+        output_key(&key, render_target, params, preview, fd->frame, cx, cy, format);
+
+        gs_texture_t *shared_tex;
+        size_t shared_frame;
+        if (output_cache_find(&key, &shared_tex, &shared_frame)) {
+            if (!fd->shared) obs_log(LOG_DEBUG, "sharing output of an identical filter");
+            fd->shared = true;
+            fd->shared_key = key;
+            fd->dirty.valid = false;
+
+            // stay in step with the instance whose output is shown; a paused
+            // one keeps the frame it stopped at
+            if (!params->paused) fd->frame = shared_frame + 1;
+            draw_frame(fd);
+            fd->frame_processed = true;
+            return;
+        }
+    }
+
+    if (preview) {
+        switch (params->preview_profile) {
+        case PREVIEW_HALF_RATE:
+            // our own last output is stale if we were sharing until now, and
+            // there is none after a resize or an idle release
+            fd->preview_skip_next = !fd->preview_skip_next || fd->shared || !fd->has_output;
+            if (!fd->preview_skip_next) {
+                draw_frame(fd);
+                fd->frame_processed = true;
+                return;
+            }
+            break;
+        default:
+            break;
+        }
+    }
+
+    // over the module's CPU budget, show the last output again instead
+    if (fd->has_output && !workers_budget_allows()) {
+        draw_frame(fd);
+        fd->frame_processed = true;
+        stats_frame(fd, 0, true);
+        return;
+    }
+
     // render frame to texture using texrender
     gs_texrender_reset(fd->texrender);
     gs_blend_state_push();
@@ -270,11 +778,11 @@ static void filter_render(void* data, gs_effect_t *effect) {
         gs_ortho(0.0f, (float)fd->cx, 0.0f, (float)fd->cy, -100.0f, 100.0f);
 
         // render
-        uint32_t target_flags = obs_source_get_output_flags(target);
-        if (target == parent && (target_flags & OBS_SOURCE_CUSTOM_DRAW) == 0 && (target_flags & OBS_SOURCE_ASYNC) == 0) {
-            obs_source_default_render(target);
+        uint32_t target_flags = obs_source_get_output_flags(render_target);
+        if (render_target == parent && (target_flags & OBS_SOURCE_CUSTOM_DRAW) == 0 && (target_flags & OBS_SOURCE_ASYNC) == 0) {
+            obs_source_default_render(render_target);
         } else {
-            obs_source_video_render(target);
+            obs_source_video_render(render_target);
         }
         gs_texrender_end(fd->texrender);
     }
@@ -288,48 +796,235 @@ static void filter_render(void* data, gs_effect_t *effect) {
         gs_texture_t *rendered_tex = gs_texrender_get_texture(fd->texrender);
         gs_stage_texture(fd->stagesurf, rendered_tex);
         if (gs_stagesurface_map(fd->stagesurf, &texdata, &linesize)) {
-            size_t h = gs_stagesurface_get_height(fd->stagesurf);
-            memcpy(fd->framebuf, texdata, linesize * h);
+            // framebuf is tightly packed; the surface's rows may be padded
+            // (D3D11 pitches often are)
+            const size_t row = (size_t)fd->cx * (gs_get_format_bpp(format) / 8);
+            const uint32_t h = gs_stagesurface_get_height(fd->stagesurf);
+            if (linesize == row) {
+                memcpy(fd->framebuf, texdata, row * h);
+            } else {
+                const size_t copy = linesize < row ? linesize : row;
+                for (uint32_t y = 0; y < h; y++)
+                    memcpy(fd->framebuf + y * row, texdata + (size_t)y * linesize, copy);
+            }
             gs_stagesurface_unmap(fd->stagesurf);
         } else {
             obs_log(LOG_ERROR, "failed to map stage surface");
         }
 
-        // map empty texture, apply effects pass to CPU buffer, then write back to texture
-        if (gs_texture_map(fd->framebuf_tex, &texdata, &linesize)) {
-            size_t h = gs_texture_get_height(fd->framebuf_tex);
-            ntscrs_apply_effect_to_buffer(
-                fd->ntsc,
-                OUTPUT_WIDTH,
-                OUTPUT_HEIGHT,
-                fd->framebuf,
-                format == GS_RGBA16F ? Rgbx16 : Rgbx8,
-                fd->frame);
-            memcpy(texdata, fd->framebuf, linesize * h);
-
-            gs_texture_unmap(fd->framebuf_tex);
+        // apply effects pass to CPU buffer, then upload into the next texture in the ring
+        const NtscRsPixelFormat pix_fmt = format == GS_RGBA16F ? Rgbx16 : Rgbx8;
+
+        // fused filters apply bottom-up, each with its own settings and frame counter
+        struct perf_sample perf_before;
+        const bool counting = perf_counters_read(&perf_before);
+        uint64_t effect_start = os_gettime_ns();
+        uint64_t effect_ns = 0;
+        for (size_t i = n_fused; i > 0; i--) {
+            struct ntscrs_filter_data *child = fused[i - 1];
+            const struct ntscrs_params *child_params = param_snapshot_acquire(&child->params);
+            if (child_params->generation == 0) continue;
+
+            apply_effect(child_params, preview, fd->framebuf, fd->cx, fd->cy, pix_fmt, child->frame);
+            if (!child_params->paused) {
+                child->frame++;
+            }
+        }
+
+        const uint32_t bytes_per_pixel = gs_get_format_bpp(format) / 8;
+        effect_ns += os_gettime_ns() - effect_start;
+        trace_capture_frame(fd, params, pix_fmt, bytes_per_pixel);
+        effect_start = os_gettime_ns();
+
+        const uint8_t *result = NULL;
+        if (params->incremental && n_fused == 0 && dirty_rows_eligible(&params->ntsc)) {
+            result = apply_effect_incremental(fd, params, preview, pix_fmt, bytes_per_pixel);
+        } else {
+            fd->dirty.valid = false;
+        }
+        if (!result) {
+            apply_effect(params, preview, fd->framebuf, fd->cx, fd->cy, pix_fmt, fd->frame);
+            result = fd->framebuf;
+        }
+        effect_ns += os_gettime_ns() - effect_start;
+        struct perf_sample perf_after;
+        if (counting && perf_counters_read(&perf_after)) {
+            struct perf_sample delta;
+            perf_sample_delta(&delta, &perf_after, &perf_before);
+            perf_sample_add(&fd->stats_perf, &delta);
+            fd->stats_pixels += (uint64_t)fd->cx * fd->cy;
+        }
+        stats_frame(fd, workers_budget_charge(effect_ns), false);
+
+        if (upload_ring_write(&fd->upload, result, fd->cx * bytes_per_pixel)) {
+            if (share) output_cache_publish(&key, fd, upload_ring_current(&fd->upload), fd->frame);
+            fd->has_output = true;
         } else {
-            obs_log(LOG_ERROR, "failed to map render target");
+            obs_log(LOG_ERROR, "failed to upload frame");
         }
+        shm_publish(fd, result, fd->cx * bytes_per_pixel, fd->cx, fd->cy, pix_fmt, bytes_per_pixel, fd->frame);
+        fd->shared = false;
     }
 
     // use effect to draw texture
     draw_frame(fd);
     fd->frame_processed = true;
 
-    if (!fd->paused) {
+    if (!params->paused) {
         fd->frame++;
     }
 }
 
-static obs_properties_t *filter_properties(void *data) {
+// libobs calls this with each frame of the source as it's due to be shown and
+// shows whatever comes back; NULL keeps the previous frame on screen.
+// The audio delay uses a latched frame interval that survives the pipeline
+// being rebuilt and only follows the measured one after a real rate change,
+// so jitter and dropped frames don't move the audio around.
+static void latch_media_interval(struct ntscrs_filter_data *fd) {
+    const uint64_t measured = media_pipeline_interval_ns(fd->media);
+    if (!measured) return;
+    const uint64_t latched = (uint64_t)os_atomic_load_long(&fd->media_interval_ns);
+    if (latched && measured * 10 >= latched * 9 && measured * 10 <= latched * 11) {
+        fd->media_interval_off = 0;
+        return;
+    }
+    if (latched && ++fd->media_interval_off < MEDIA_RELATCH_FRAMES) return;
+    fd->media_interval_off = 0;
+    os_atomic_set_long(&fd->media_interval_ns, (long)measured);
+}
+
+static struct obs_source_frame *filter_media_video(void *data, struct obs_source_frame *frame) {
+    struct ntscrs_filter_data *fd = data;
+    fd->last_used_ns = os_gettime_ns();
+
+    if (!media_pipeline_supports(frame->format)) {
+        if (!fd->media_format_warned) {
+            obs_log(LOG_WARNING, "media filter: frames in video format %d are shown unprocessed", (int)frame->format);
+            fd->media_format_warned = true;
+        }
+        return frame;
+    }
+
+    // settings from filter_create haven't been applied yet
+    const struct ntscrs_params *params = param_snapshot_acquire(&fd->params);
+    if (params->generation == 0) return frame;
+
+    const uint32_t depth = (uint32_t)os_atomic_load_long(&fd->media_depth);
+    if (fd->media && media_pipeline_depth(fd->media) != depth) {
+        media_pipeline_destroy(fd->media);
+        fd->media = NULL;
+    }
+    if (!fd->media && !(fd->media = media_pipeline_create(depth))) return frame;
+
+    // over the module's CPU budget, keep showing the last output
+    if (fd->has_output && !workers_budget_allows()) {
+        obs_source_release_frame(obs_filter_get_parent(fd->context), frame);
+        stats_frame(fd, 0, true);
+        return NULL;
+    }
+
+    // the effect's frame number follows the source's timestamps, so frames
+    // the source drops or repeats don't shift the noise of the ones after
+    if (!params->paused) {
+        fd->frame += media_pipeline_frames_since(fd->media, frame->timestamp);
+    }
+
+    uint64_t wall_ns;
+    struct obs_source_frame *out = media_pipeline_push(fd->media, obs_filter_get_parent(fd->context), frame, params,
+                                                       use_draft(params, false), fd->frame, &wall_ns);
+    if (out) {
+        fd->has_output = true;
+        stats_frame(fd, workers_budget_charge(wall_ns), false);
+        shm_publish(fd, out->data[0], out->linesize[0], out->width, out->height,
+                    out->format == VIDEO_FORMAT_RGBA ? Rgbx8 : Bgrx8, 4, media_pipeline_shown_frame(fd->media));
+    }
+
+    latch_media_interval(fd);
+    const uint64_t bytes = media_pipeline_bytes(fd->media);
+    if (bytes != fd->media_bytes) {
+        fd->media_bytes = bytes;
+        account_memory(fd);
+    }
+    return out;
+}
+
+// Video comes out of the pipeline late, so the audio is held back by as much,
+// the same way the async delay filter does it.
+static struct obs_audio_data *filter_media_audio(void *data, struct obs_audio_data *audio) {
+    struct ntscrs_filter_data *fd = data;
+    const uint64_t frames = (uint64_t)(os_atomic_load_long(&fd->media_depth) - 1);
+    audio->timestamp += frames * (uint64_t)os_atomic_load_long(&fd->media_interval_ns);
+    return audio;
+}
+
+static bool trace_capture_clicked(obs_properties_t *props, obs_property_t *property, void *data) {
+    UNUSED_PARAMETER(props);
+    UNUSED_PARAMETER(property);
+    struct ntscrs_filter_data *fd = data;
+
+    os_atomic_store_bool(&fd->trace_requested, true);
+    return false;
+}
+
+static bool autotune_clicked(obs_properties_t *props, obs_property_t *property, void *data) {
+    UNUSED_PARAMETER(props);
+    UNUSED_PARAMETER(property);
     UNUSED_PARAMETER(data);
 
+    if (!autotune_start()) {
+        obs_log(LOG_INFO, "autotune: already running");
+    }
+    return false;
+}
+
+static obs_properties_t *make_properties(struct ntscrs_filter_data *fd, bool media) {
     obs_properties_t *props = obs_properties_create();
     obs_property_t *paused = obs_properties_add_bool(
         props, PROP_PAUSED, "Pause"
     );
     UNUSED_PARAMETER(paused);
+    obs_property_t *quality = obs_properties_add_list(
+        props, PROP_QUALITY, "Quality", OBS_COMBO_TYPE_LIST, OBS_COMBO_FORMAT_INT
+    );
+    obs_property_list_add_int(quality, "Full", QUALITY_FULL);
+    obs_property_list_add_int(quality, "Draft (half horizontal resolution, 8-bit sources)", QUALITY_DRAFT);
+    obs_property_set_long_description(quality,
+        "Draft runs the effect on a half-width copy of 8-bit frames and scales the result back up. "
+        "Roughly halves CPU time; intended for previews. Has no effect on HDR sources.");
+    if (media) {
+        obs_property_t *media_depth = obs_properties_add_int(
+            props, PROP_MEDIA_DEPTH, "Frames processed at once", 1, MEDIA_PIPELINE_MAX_DEPTH, 1
+        );
+        obs_property_set_long_description(media_depth,
+            "Processes this many frames of the source in parallel, which keeps more cores busy when single frames "
+            "take too long. Video and audio are delayed by one frame less than this.");
+    } else {
+        obs_property_t *preview_profile = obs_properties_add_list(
+            props, PROP_PREVIEW_PROFILE, "Preview-only quality", OBS_COMBO_TYPE_LIST, OBS_COMBO_FORMAT_INT
+        );
+        obs_property_list_add_int(preview_profile, "Same as program", PREVIEW_FULL);
+        obs_property_list_add_int(preview_profile, "Draft", PREVIEW_DRAFT);
+        obs_property_list_add_int(preview_profile, "Half frame rate", PREVIEW_HALF_RATE);
+        obs_property_list_add_int(preview_profile, "Pass-through (no effect)", PREVIEW_PASSTHROUGH);
+        obs_property_set_long_description(preview_profile,
+            "Used while the source is visible but not on program, e.g. in the studio mode preview, "
+            "projectors or multiview. The program output always gets the quality set above.");
+        obs_property_t *incremental = obs_properties_add_bool(
+            props, PROP_INCREMENTAL, "Only reprocess changed rows"
+        );
+        obs_property_set_long_description(incremental,
+            "For mostly static sources such as tickers, overlays or HUDs. Takes effect only while head switching, "
+            "tracking noise, all noise and snow, chroma phase noise, VHS edge wave and chroma loss, and "
+            "\"Scale with video size\" are off, and a single field or both fields are used. "
+            "The effect's frame number is held still, so dot crawl stops animating.");
+        obs_property_t *share_output = obs_properties_add_bool(
+            props, PROP_SHARE_OUTPUT, "Share output with identical filters"
+        );
+        obs_property_set_long_description(share_output,
+            "When several ntsc-rs filters with the same settings sit directly on the same source and render in the "
+            "same frame, e.g. during transitions or in multiview, only one of them processes it and the others show "
+            "its result. Their noise and dot crawl stay in step with each other.");
+    }
     obs_property_t *random_seed = obs_properties_add_int(
         props, PROP_RANDOM_SEED, "Random seed", INT32_MIN, INT32_MAX, 1
     );
@@ -630,9 +1325,103 @@ static obs_properties_t *filter_properties(void *data) {
     UNUSED_PARAMETER(vertical_scale);
     UNUSED_PARAMETER(scale_with_video_size);
 
+    /*
+    * TRACE CAPTURE
+    */
+    // traces are recorded from the render path, which the media filter doesn't use
+    if (!media) {
+        obs_property_t *trace_path = obs_properties_add_path(
+            props, PROP_TRACE_PATH, "Trace capture: File", OBS_PATH_FILE_SAVE, "ntsc-rs trace (*.ntsctrace)", NULL
+        );
+        obs_property_t *trace_frames = obs_properties_add_int(
+            props, PROP_TRACE_FRAMES, "Trace capture: Frames", 1, 100000, 1
+        );
+        obs_property_t *trace_compress = obs_properties_add_bool(
+            props, PROP_TRACE_COMPRESS, "Trace capture: LZ4 compression"
+        );
+        obs_property_t *trace_capture = obs_properties_add_button(
+            props, PROP_TRACE_CAPTURE, "Capture trace", trace_capture_clicked
+        );
+        obs_property_set_long_description(trace_capture,
+            "Records the next frames this filter processes, with their parameters, for offline replay. "
+            "Frames are written from the render thread, so expect dropped frames while capturing.");
+        UNUSED_PARAMETER(trace_path);
+        UNUSED_PARAMETER(trace_frames);
+        UNUSED_PARAMETER(trace_compress);
+    }
+
+    /*
+    * SHARED MEMORY OUTPUT
+    */
+    obs_property_t *shm_name = obs_properties_add_text(
+        props, PROP_SHM_NAME, "Publish to shared memory: Name", OBS_TEXT_DEFAULT
+    );
+    obs_property_set_long_description(shm_name,
+        "Writes every frame this filter processes into a shared-memory ring of this name, for recorders or other "
+        "processes on this machine to read without another copy from the GPU (see ntscrs-shm-read). Names must be "
+        "unique. Empty turns it off. Not available on Windows.");
+
+    obs_property_t *autotune = obs_properties_add_button(
+        props, PROP_AUTOTUNE, "Tune thread count for this machine", autotune_clicked
+    );
+    obs_property_set_long_description(autotune,
+        "Benchmarks the effect at the canvas size with different numbers of worker threads and keeps the best one "
+        "for all ntsc-rs filters. Runs in the background for a few seconds, once automatically on first use; "
+        "results are in the log. Best run while nothing else is busy.");
+
+    // a snapshot; it's refreshed whenever the properties are opened again
+    char cpu_stats[256];
+    const uint32_t budget = workers_cpu_budget();
+    const long processed = fd ? os_atomic_load_long(&fd->stats_last_processed) : 0;
+    const long reused = fd ? os_atomic_load_long(&fd->stats_last_reused) : 0;
+    if (processed + reused == 0) {
+        snprintf(cpu_stats, sizeof(cpu_stats), "Effect CPU use: not measured yet");
+    } else if (budget) {
+        snprintf(cpu_stats, sizeof(cpu_stats),
+                 "Effect CPU use: %.1f%% of one core; %ld of %ld frames repeated to stay within the %u%% budget",
+                 os_atomic_load_long(&fd->stats_last_cpu_permille) / 10.0, reused, processed + reused, budget);
+    } else {
+        snprintf(cpu_stats, sizeof(cpu_stats), "Effect CPU use: %.1f%% of one core, no budget set",
+                 os_atomic_load_long(&fd->stats_last_cpu_permille) / 10.0);
+    }
+    obs_property_t *cpu_use = obs_properties_add_text(props, PROP_CPU_STATS, cpu_stats, OBS_TEXT_INFO);
+    obs_property_set_long_description(cpu_use,
+        "Measured over the last 10 seconds. Worker priority and the CPU budget shared by all ntsc-rs filters are "
+        "set in workers.json in the plugin's config directory and take effect when OBS is restarted.");
+
+    struct mem_usage own, total;
+    char own_text[128], total_text[128], mem_stats[400];
+    size_t effects, effect_refs;
+    mem_stats_get(fd ? &fd->mem : NULL, &own, &total);
+    mem_stats_format(own_text, sizeof(own_text), &own);
+    mem_stats_format(total_text, sizeof(total_text), &total);
+    effect_cache_stats(&effects, &effect_refs);
+    if (fd) {
+        snprintf(mem_stats, sizeof(mem_stats),
+                 "Memory: %s. All ntsc-rs filters: %s; %zu prepared effects, %zu references", own_text, total_text,
+                 effects, effect_refs);
+    } else {
+        snprintf(mem_stats, sizeof(mem_stats), "Memory, all ntsc-rs filters: %s; %zu prepared effects, %zu references",
+                 total_text, effects, effect_refs);
+    }
+    obs_property_t *memory = obs_properties_add_text(props, PROP_MEMORY_STATS, mem_stats, OBS_TEXT_INFO);
+    obs_property_set_long_description(memory,
+        "As of when the properties were opened. The effect heap (prepared effects and the scratch frames are processed "
+        "in) is shared by all ntsc-rs filters, which process frames side by side, so it's only shown for all of them, "
+        "along with the most it has held at once. Filters whose settings come out the same share one prepared effect. "
+        "References count each filter's current and last few settings, and frames being processed for video sources.");
+
     return props;
 }
 
+static obs_properties_t *filter_properties(void *data) {
+    return make_properties(data, false);
+}
+
+static obs_properties_t *filter_media_properties(void *data) {
+    return make_properties(data, true);
+}
+
 static uint32_t filter_get_height(void *data) {
     struct ntscrs_filter_data *const fd = data;
     return OUTPUT_HEIGHT;
@@ -714,11 +1503,19 @@ void filter_get_defaults(void *data, obs_data_t *settings)
     obs_data_set_default_bool(s, PROP_SCALE_WITH_VIDEO_SIZE, p.scale.scale_with_video_size);
 
     obs_data_set_default_bool(s, PROP_PAUSED, false);
+    obs_data_set_default_int(s, PROP_QUALITY, QUALITY_FULL);
+    obs_data_set_default_int(s, PROP_PREVIEW_PROFILE, PREVIEW_FULL);
+    obs_data_set_default_bool(s, PROP_INCREMENTAL, false);
+    obs_data_set_default_bool(s, PROP_SHARE_OUTPUT, true);
+    obs_data_set_default_int(s, PROP_MEDIA_DEPTH, 3);
+
+    obs_data_set_default_int(s, PROP_TRACE_FRAMES, 300);
+    obs_data_set_default_bool(s, PROP_TRACE_COMPRESS, false);
 }
 
 static void filter_update(void *data, obs_data_t *s) {
     struct ntscrs_filter_data *fd = data;
-    struct NtscRsEffectParams *p = &fd->ntsc;
+    struct NtscRsEffectParams *p = &fd->settings.ntsc;
 
     p->enable_head_switching = obs_data_get_bool(s, PROP_HEAD_SWITCHING);
     p->enable_tracking_noise = obs_data_get_bool(s, PROP_TRACKING_NOISE);
@@ -797,7 +1594,37 @@ static void filter_update(void *data, obs_data_t *s) {
     p->scale.vertical_scale = obs_data_get_double(s, PROP_VERTICAL_SCALE);
     p->scale.scale_with_video_size = obs_data_get_bool(s, PROP_SCALE_WITH_VIDEO_SIZE);
 
-    fd->paused = obs_data_get_bool(s, PROP_PAUSED);
+    fd->settings.paused = obs_data_get_bool(s, PROP_PAUSED);
+    fd->settings.quality = obs_data_get_int(s, PROP_QUALITY);
+    fd->settings.preview_profile = obs_data_get_int(s, PROP_PREVIEW_PROFILE);
+    fd->settings.incremental = obs_data_get_bool(s, PROP_INCREMENTAL);
+    fd->settings.share_output = obs_data_get_bool(s, PROP_SHARE_OUTPUT);
+    const long media_depth = (long)obs_data_get_int(s, PROP_MEDIA_DEPTH);
+    os_atomic_set_long(&fd->media_depth, media_depth < 1                          ? 1
+                                         : media_depth > MEDIA_PIPELINE_MAX_DEPTH ? MEDIA_PIPELINE_MAX_DEPTH
+                                                                                  : media_depth);
+
+    pthread_mutex_lock(&fd->trace_mutex);
+    bfree(fd->trace_path);
+    fd->trace_path = bstrdup(obs_data_get_string(s, PROP_TRACE_PATH));
+    fd->trace_frames = (uint32_t)obs_data_get_int(s, PROP_TRACE_FRAMES);
+    fd->trace_compress = obs_data_get_bool(s, PROP_TRACE_COMPRESS);
+    pthread_mutex_unlock(&fd->trace_mutex);
+
+    const char *shm_name = obs_data_get_string(s, PROP_SHM_NAME);
+    pthread_mutex_lock(&fd->shm_mutex);
+    if (strcmp(fd->shm_name ? fd->shm_name : "", shm_name) != 0) {
+        bfree(fd->shm_name);
+        fd->shm_name = bstrdup(shm_name);
+        os_atomic_inc_long(&fd->shm_changes);
+    }
+    os_atomic_set_bool(&fd->shm_enabled, *shm_name != 0);
+    pthread_mutex_unlock(&fd->shm_mutex);
+
+    // libobs runs updates of video filters on the video thread just before
+    // rendering, so the rest happens on the builder's thread; the render
+    // thread gets the complete set in one step once it's ready
+    param_job_submit(&fd->param_job, &fd->settings);
 }
 
 static enum gs_color_space filter_get_color_space(void *data, size_t count, const enum gs_color_space *preferred_spaces) {
@@ -818,7 +1645,7 @@ static enum gs_color_space filter_get_color_space(void *data, size_t count, cons
 }
 
 struct obs_source_info ntscrs_filter = {
-    .id = "ntsc_rs_filter",
+    .id = NTSCRS_FILTER_ID,
     .type = OBS_SOURCE_TYPE_FILTER,
     .output_flags = OBS_SOURCE_VIDEO | OBS_SOURCE_CUSTOM_DRAW,
     .get_name = filter_getname,
@@ -834,8 +1661,27 @@ struct obs_source_info ntscrs_filter = {
     .video_get_color_space = filter_get_color_space,
 };
 
+struct obs_source_info ntscrs_media_filter = {
+    .id = NTSCRS_MEDIA_FILTER_ID,
+    .type = OBS_SOURCE_TYPE_FILTER,
+    .output_flags = OBS_SOURCE_ASYNC_VIDEO,
+    .get_name = filter_media_getname,
+    .create = filter_create,
+    .destroy = filter_destroy,
+    .get_defaults2 = filter_get_defaults,
+    .get_properties = filter_media_properties,
+    .update = filter_update,
+    .video_tick = filter_tick,
+    .filter_video = filter_media_video,
+    .filter_audio = filter_media_audio,
+};
+
 bool obs_module_load(void) {
     obs_register_source(&ntscrs_filter);
+    obs_register_source(&ntscrs_media_filter);
+    workers_init();
+    autotune_init();
+    param_builder_init();
 
     obs_log(LOG_INFO, "ntsc-rs-obs loaded successfully (version %s)",
          PLUGIN_VERSION);
@@ -844,5 +1690,8 @@ bool obs_module_load(void) {
 
 void obs_module_unload()
 {
+    autotune_shutdown();
+    param_builder_shutdown();
+    frame_pool_shutdown();
     obs_log(LOG_INFO, "plugin unloaded");
 }
@@ -70,3 +70,17 @@
 #define PROP_LUMA_NOISE_FREQUENCY "ntsc_luma_noise_frequency"
 #define PROP_LUMA_NOISE_INTENSITY "ntsc_luma_noise_intensity"
 #define PROP_LUMA_NOISE_DETAIL "ntsc_luma_noise_detail"
+
+#define PROP_TRACE_PATH "ntsc_trace_path"
+#define PROP_TRACE_FRAMES "ntsc_trace_frames"
+#define PROP_TRACE_COMPRESS "ntsc_trace_compress"
+#define PROP_TRACE_CAPTURE "ntsc_trace_capture"
+#define PROP_SHM_NAME "ntsc_shm_name"
+#define PROP_QUALITY "ntsc_quality"
+#define PROP_PREVIEW_PROFILE "ntsc_preview_profile"
+#define PROP_INCREMENTAL "ntsc_incremental"
+#define PROP_SHARE_OUTPUT "ntsc_share_output"
+#define PROP_MEDIA_DEPTH "ntsc_media_depth"
+#define PROP_AUTOTUNE "ntsc_autotune"
+#define PROP_CPU_STATS "ntsc_cpu_stats"
+#define PROP_MEMORY_STATS "ntsc_memory_stats"
@@ -0,0 +1,313 @@
+/*
+ntsc-rs-obs
+Copyright (C) 2025 eigenpunk
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along
+with this program. If not, see <https://www.gnu.org/licenses/>
+*/
+
+#include <stdlib.h>
+#include <string.h>
+
+#ifndef _WIN32
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+#endif
+
+#include "shm-ring.h"
+
+static inline uint64_t align_up(uint64_t v) {
+    return (v + NTSCRS_SHM_ALIGN - 1) & ~(uint64_t)(NTSCRS_SHM_ALIGN - 1);
+}
+
+#define HEADER_SIZE align_up(sizeof(struct ntscrs_shm_header))
+#define SLOT_HEADER_SIZE align_up(sizeof(struct ntscrs_shm_slot))
+
+static inline struct ntscrs_shm_slot *slot_at(const void *base, const struct ntscrs_shm_header *h, uint64_t index) {
+    return (struct ntscrs_shm_slot *)((uint8_t *)base + HEADER_SIZE + ((index - 1) % h->slot_count) * h->slot_size);
+}
+
+#ifdef _WIN32
+
+struct ntscrs_shm_writer *ntscrs_shm_writer_create(const char *name, uint32_t width, uint32_t height,
+                                                   NtscRsPixelFormat pix_fmt, uint32_t bytes_per_pixel,
+                                                   uint32_t slot_count) {
+    (void)name, (void)width, (void)height, (void)pix_fmt, (void)bytes_per_pixel, (void)slot_count;
+    return NULL;
+}
+
+bool ntscrs_shm_writer_fits(const struct ntscrs_shm_writer *w, uint32_t width, uint32_t height,
+                            NtscRsPixelFormat pix_fmt) {
+    (void)w, (void)width, (void)height, (void)pix_fmt;
+    return false;
+}
+
+void ntscrs_shm_publish(struct ntscrs_shm_writer *w, const uint8_t *data, size_t linesize, uint64_t frame_num) {
+    (void)w, (void)data, (void)linesize, (void)frame_num;
+}
+
+void ntscrs_shm_writer_destroy(struct ntscrs_shm_writer *w) {
+    (void)w;
+}
+
+bool ntscrs_shm_open(struct ntscrs_shm_reader *r, const char *name) {
+    (void)name;
+    memset(r, 0, sizeof(*r));
+    return false;
+}
+
+void ntscrs_shm_close(struct ntscrs_shm_reader *r) {
+    memset(r, 0, sizeof(*r));
+}
+
+uint64_t ntscrs_shm_published(const struct ntscrs_shm_reader *r) {
+    (void)r;
+    return 0;
+}
+
+bool ntscrs_shm_closed(const struct ntscrs_shm_reader *r) {
+    (void)r;
+    return true;
+}
+
+const uint8_t *ntscrs_shm_frame(const struct ntscrs_shm_reader *r, uint64_t index,
+                                const struct ntscrs_shm_slot **slot, uint64_t *seq) {
+    (void)r, (void)index, (void)slot, (void)seq;
+    return NULL;
+}
+
+bool ntscrs_shm_frame_valid(const struct ntscrs_shm_slot *slot, uint64_t seq) {
+    (void)slot, (void)seq;
+    return false;
+}
+
+#else
+
+// "/name", which is what shm_open wants
+static char *object_name(const char *name) {
+    const size_t len = strlen(name);
+    char *path = malloc(len + 2);
+    if (!path) return NULL;
+    path[0] = '/';
+    memcpy(path + 1, name[0] == '/' ? name + 1 : name, name[0] == '/' ? len : len + 1);
+    return path;
+}
+
+/*
+ * Writing
+ */
+
+struct ntscrs_shm_writer {
+    char *name;
+    uint8_t *base;
+    size_t size;
+    struct ntscrs_shm_header *header;
+};
+
+// Tells readers of a ring already under path, left by a crash or another
+// writer, to let go of it. The name goes first, so that readers opening it
+// again don't find the old object. Returns false, leaving it alone, if the
+// object there isn't one of our rings.
+static bool close_existing(const char *path) {
+    const int fd = shm_open(path, O_RDWR, 0);
+    if (fd < 0) return true;
+
+    bool ours = false;
+    struct stat st;
+    if (fstat(fd, &st) == 0 && (size_t)st.st_size >= sizeof(struct ntscrs_shm_header)) {
+        struct ntscrs_shm_header *h = mmap(NULL, sizeof(*h), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        if (h != MAP_FAILED) {
+            ours = memcmp(h->magic, NTSCRS_SHM_MAGIC, sizeof(h->magic)) == 0;
+            if (ours) {
+                shm_unlink(path);
+                __atomic_store_n(&h->closed, 1, __ATOMIC_RELEASE);
+            }
+            munmap(h, sizeof(*h));
+        }
+    }
+    close(fd);
+    return ours;
+}
+
+struct ntscrs_shm_writer *ntscrs_shm_writer_create(const char *name, uint32_t width, uint32_t height,
+                                                   NtscRsPixelFormat pix_fmt, uint32_t bytes_per_pixel,
+                                                   uint32_t slot_count) {
+    if (!name[0] || !width || !height || !slot_count) return NULL;
+
+    struct ntscrs_shm_writer *w = calloc(1, sizeof(*w));
+    if (!w) return NULL;
+    if (!(w->name = object_name(name))) goto fail;
+
+    const uint32_t linesize = width * bytes_per_pixel;
+    const uint64_t slot_size = SLOT_HEADER_SIZE + align_up((uint64_t)linesize * height);
+    w->size = HEADER_SIZE + slot_count * slot_size;
+
+    if (!close_existing(w->name)) {
+        errno = EEXIST;
+        goto fail;
+    }
+    const int fd = shm_open(w->name, O_RDWR | O_CREAT | O_EXCL, 0600);
+    if (fd < 0) goto fail;
+    if (ftruncate(fd, (off_t)w->size) != 0) {
+        close(fd);
+        shm_unlink(w->name);
+        goto fail;
+    }
+    w->base = mmap(NULL, w->size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (w->base == MAP_FAILED) {
+        w->base = NULL;
+        shm_unlink(w->name);
+        goto fail;
+    }
+
+    // the object starts out zeroed
+    struct ntscrs_shm_header *h = w->header = (struct ntscrs_shm_header *)w->base;
+    h->version = NTSCRS_SHM_VERSION;
+    h->slot_count = slot_count;
+    h->width = width;
+    h->height = height;
+    h->pix_fmt = (uint32_t)pix_fmt;
+    h->bytes_per_pixel = bytes_per_pixel;
+    h->linesize = linesize;
+    h->slot_size = slot_size;
+    // readers check the magic first, so it goes in last
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+    memcpy(h->magic, NTSCRS_SHM_MAGIC, sizeof(h->magic));
+    return w;
+
+fail:
+    free(w->name);
+    free(w);
+    return NULL;
+}
+
+bool ntscrs_shm_writer_fits(const struct ntscrs_shm_writer *w, uint32_t width, uint32_t height,
+                            NtscRsPixelFormat pix_fmt) {
+    const struct ntscrs_shm_header *h = w->header;
+    return h->width == width && h->height == height && h->pix_fmt == (uint32_t)pix_fmt;
+}
+
+void ntscrs_shm_publish(struct ntscrs_shm_writer *w, const uint8_t *data, size_t linesize, uint64_t frame_num) {
+    struct ntscrs_shm_header *h = w->header;
+    // only the writer changes published
+    const uint64_t index = h->published + 1;
+    struct ntscrs_shm_slot *slot = slot_at(w->base, h, index);
+    uint8_t *pixels = (uint8_t *)slot + SLOT_HEADER_SIZE;
+
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    const uint64_t seq = slot->seq;
+    __atomic_store_n(&slot->seq, seq + 1, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+
+    slot->index = index;
+    slot->frame_num = frame_num;
+    slot->timestamp_ns = (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+    if (linesize == h->linesize) {
+        memcpy(pixels, data, (size_t)h->linesize * h->height);
+    } else {
+        for (uint32_t y = 0; y < h->height; y++)
+            memcpy(pixels + (size_t)y * h->linesize, data + y * linesize, h->linesize);
+    }
+
+    __atomic_store_n(&slot->seq, seq + 2, __ATOMIC_RELEASE);
+    __atomic_store_n(&h->published, index, __ATOMIC_RELEASE);
+}
+
+void ntscrs_shm_writer_destroy(struct ntscrs_shm_writer *w) {
+    if (!w) return;
+    // as in close_existing; a ring another writer took over no longer owns
+    // the name
+    if (!__atomic_load_n(&w->header->closed, __ATOMIC_ACQUIRE)) shm_unlink(w->name);
+    __atomic_store_n(&w->header->closed, 1, __ATOMIC_RELEASE);
+    munmap(w->base, w->size);
+    free(w->name);
+    free(w);
+}
+
+/*
+ * Reading
+ */
+
+bool ntscrs_shm_open(struct ntscrs_shm_reader *r, const char *name) {
+    memset(r, 0, sizeof(*r));
+    char *path = object_name(name);
+    if (!path) return false;
+    const int fd = shm_open(path, O_RDONLY, 0);
+    free(path);
+    if (fd < 0) return false;
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || (size_t)st.st_size < HEADER_SIZE) {
+        close(fd);
+        return false;
+    }
+    void *base = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (base == MAP_FAILED) return false;
+
+    r->mapping = base;
+    r->size = (size_t)st.st_size;
+    r->header = base;
+
+    // the rest of the header is only complete once the magic is there
+    const struct ntscrs_shm_header *h = r->header;
+    bool valid = memcmp(h->magic, NTSCRS_SHM_MAGIC, sizeof(h->magic)) == 0;
+    __atomic_thread_fence(__ATOMIC_ACQUIRE);
+    valid = valid && h->version == NTSCRS_SHM_VERSION && h->slot_count > 0 &&
+            h->slot_size >= SLOT_HEADER_SIZE + (uint64_t)h->linesize * h->height &&
+            HEADER_SIZE + h->slot_count * h->slot_size <= r->size;
+    if (!valid) {
+        ntscrs_shm_close(r);
+        return false;
+    }
+    return true;
+}
+
+void ntscrs_shm_close(struct ntscrs_shm_reader *r) {
+    if (r->mapping) munmap(r->mapping, r->size);
+    memset(r, 0, sizeof(*r));
+}
+
+uint64_t ntscrs_shm_published(const struct ntscrs_shm_reader *r) {
+    return __atomic_load_n(&r->header->published, __ATOMIC_ACQUIRE);
+}
+
+bool ntscrs_shm_closed(const struct ntscrs_shm_reader *r) {
+    return __atomic_load_n(&r->header->closed, __ATOMIC_ACQUIRE) != 0;
+}
+
+const uint8_t *ntscrs_shm_frame(const struct ntscrs_shm_reader *r, uint64_t index,
+                                const struct ntscrs_shm_slot **slot, uint64_t *seq) {
+    if (index == 0) return NULL;
+    const struct ntscrs_shm_slot *s = slot_at(r->mapping, r->header, index);
+    const uint64_t before = __atomic_load_n(&s->seq, __ATOMIC_ACQUIRE);
+    if ((before & 1) || s->index != index) return NULL;
+
+    *slot = s;
+    *seq = before;
+    return (const uint8_t *)s + SLOT_HEADER_SIZE;
+}
+
+bool ntscrs_shm_frame_valid(const struct ntscrs_shm_slot *slot, uint64_t seq) {
+    __atomic_thread_fence(__ATOMIC_ACQUIRE);
+    return __atomic_load_n(&slot->seq, __ATOMIC_RELAXED) == seq;
+}
+
+#endif
@@ -0,0 +1,120 @@
+/*
+ntsc-rs-obs
+Copyright (C) 2025 eigenpunk
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along
+with this program. If not, see <https://www.gnu.org/licenses/>
+*/
+
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include <ntscrs.h>
+
+// A ring of processed frames in POSIX shared memory, so that other processes
+// on the machine (recorders, analysis) can read a filter's output straight
+// from the buffer it was processed in, without another GPU readback or a
+// virtual camera. Layout of the object:
+//
+//   header | slot, pixels | slot, pixels | ...
+//
+// Slots and their pixels start on NTSCRS_SHM_ALIGN boundaries. Each slot is
+// guarded by a seqlock: seq is odd while the writer fills it, and a reader
+// that sees the same even seq before and after reading has an untorn frame.
+// The writer never waits for readers; one that falls more than slot_count
+// frames behind finds its frames overwritten.
+//
+// The frame size and format are fixed for the life of the object. When they
+// change the writer sets closed and replaces the object under the same name,
+// and readers have to open it again. POSIX only; creating a ring fails on
+// Windows.
+
+#define NTSCRS_SHM_MAGIC "NTSCSHMR"
+#define NTSCRS_SHM_VERSION 1
+#define NTSCRS_SHM_ALIGN 64
+
+struct ntscrs_shm_header {
+    char magic[8];
+    uint32_t version;
+    uint32_t slot_count;
+    uint32_t width;
+    uint32_t height;
+    uint32_t pix_fmt; // NtscRsPixelFormat
+    uint32_t bytes_per_pixel;
+    uint32_t linesize;
+    uint32_t closed;     // set once the writer is gone
+    uint64_t slot_size;  // from one slot to the next, including the slot
+    uint64_t published;  // frames written so far; frame n (from 1) is in slot (n - 1) % slot_count
+};
+
+struct ntscrs_shm_slot {
+    uint64_t seq;          // odd while being written
+    uint64_t index;        // which frame of the ring this is, see published
+    uint64_t frame_num;    // the filter's effect frame number
+    uint64_t timestamp_ns; // CLOCK_MONOTONIC when published
+};
+
+/*
+ * Writing
+ */
+
+struct ntscrs_shm_writer;
+
+// Creates (or takes over a ring left under) the object called name; a leading
+// '/' is added if it's missing. Fails with errno set to EEXIST if name is
+// taken by something that isn't a ring.
+struct ntscrs_shm_writer *ntscrs_shm_writer_create(const char *name, uint32_t width, uint32_t height,
+                                                   NtscRsPixelFormat pix_fmt, uint32_t bytes_per_pixel,
+                                                   uint32_t slot_count);
+
+// whether frames of this size and format can go into the ring as it is
+bool ntscrs_shm_writer_fits(const struct ntscrs_shm_writer *w, uint32_t width, uint32_t height,
+                            NtscRsPixelFormat pix_fmt);
+
+// copies height rows of width * bytes_per_pixel bytes from data into the next slot
+void ntscrs_shm_publish(struct ntscrs_shm_writer *w, const uint8_t *data, size_t linesize, uint64_t frame_num);
+
+// marks the ring closed and removes the name
+void ntscrs_shm_writer_destroy(struct ntscrs_shm_writer *w);
+
+/*
+ * Reading
+ */
+
+struct ntscrs_shm_reader {
+    const struct ntscrs_shm_header *header;
+    size_t size;
+
+    void *mapping;
+};
+
+bool ntscrs_shm_open(struct ntscrs_shm_reader *r, const char *name);
+void ntscrs_shm_close(struct ntscrs_shm_reader *r);
+
+// frames written so far, see ntscrs_shm_header.published
+uint64_t ntscrs_shm_published(const struct ntscrs_shm_reader *r);
+
+// whether the writer has gone away or replaced the ring; open it again
+bool ntscrs_shm_closed(const struct ntscrs_shm_reader *r);
+
+// Returns frame index (from 1) in place in the mapping, with its slot and the
+// seq to check it against once done with the pixels; NULL if it has been
+// overwritten already or is being written right now.
+const uint8_t *ntscrs_shm_frame(const struct ntscrs_shm_reader *r, uint64_t index,
+                                const struct ntscrs_shm_slot **slot, uint64_t *seq);
+
+// whether the frame was left alone while it was being read
+bool ntscrs_shm_frame_valid(const struct ntscrs_shm_slot *slot, uint64_t seq);
@@ -0,0 +1,268 @@
+/*
+ntsc-rs-obs
+Copyright (C) 2025 eigenpunk
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along
+with this program. If not, see <https://www.gnu.org/licenses/>
+*/
+
+#include <stdlib.h>
+#include <string.h>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#ifdef NTSCRS_TRACE_HAVE_LZ4
+#include <lz4.h>
+#endif
+
+#include "trace.h"
+
+static inline uint64_t align_up(uint64_t v) {
+    return (v + NTSCRS_TRACE_ALIGN - 1) & ~(uint64_t)(NTSCRS_TRACE_ALIGN - 1);
+}
+
+/*
+ * Writing
+ */
+
+struct ntscrs_trace_writer {
+    FILE *file;
+    struct ntscrs_trace_header header;
+    uint64_t offset;
+
+    uint64_t *index;
+    size_t index_capacity;
+
+    uint8_t *compressed;
+    size_t compressed_capacity;
+};
+
+static bool write_bytes(struct ntscrs_trace_writer *w, const void *data, size_t size) {
+    if (size && fwrite(data, 1, size, w->file) != size) return false;
+    w->offset += size;
+    return true;
+}
+
+static bool write_padding(struct ntscrs_trace_writer *w) {
+    static const uint8_t zeros[NTSCRS_TRACE_ALIGN] = {0};
+    return write_bytes(w, zeros, (size_t)(align_up(w->offset) - w->offset));
+}
+
+struct ntscrs_trace_writer *ntscrs_trace_writer_create(FILE *file, uint32_t width, uint32_t height,
+                                                       NtscRsPixelFormat pix_fmt, uint32_t bytes_per_pixel,
+                                                       bool compress) {
+    if (!file) return NULL;
+
+    struct ntscrs_trace_writer *w = calloc(1, sizeof(*w));
+    if (!w) {
+        fclose(file);
+        return NULL;
+    }
+
+    w->file = file;
+    memcpy(w->header.magic, NTSCRS_TRACE_MAGIC, sizeof(w->header.magic));
+    w->header.version = NTSCRS_TRACE_VERSION;
+    w->header.params_size = sizeof(NtscRsEffectParams);
+    w->header.width = width;
+    w->header.height = height;
+    w->header.pix_fmt = (uint32_t)pix_fmt;
+    w->header.bytes_per_pixel = bytes_per_pixel;
+#ifdef NTSCRS_TRACE_HAVE_LZ4
+    if (compress) w->header.flags |= NTSCRS_TRACE_LZ4;
+#else
+    (void)compress;
+#endif
+
+    // placeholder, rewritten with the final counts on close
+    if (!write_bytes(w, &w->header, sizeof(w->header)) || !write_padding(w)) {
+        fclose(file);
+        free(w);
+        return NULL;
+    }
+    return w;
+}
+
+bool ntscrs_trace_write_frame(struct ntscrs_trace_writer *w, const NtscRsEffectParams *params, uint64_t frame_num,
+                              const uint8_t *data, size_t size) {
+    if (w->header.frame_count == w->index_capacity) {
+        size_t capacity = w->index_capacity ? w->index_capacity * 2 : 64;
+        uint64_t *index = realloc(w->index, capacity * sizeof(*index));
+        if (!index) return false;
+        w->index = index;
+        w->index_capacity = capacity;
+    }
+
+    struct ntscrs_trace_record record;
+    memset(&record, 0, sizeof(record));
+    record.frame_num = frame_num;
+    record.params = *params;
+    record.raw_size = size;
+    record.payload_size = size;
+
+    const uint8_t *payload = data;
+#ifdef NTSCRS_TRACE_HAVE_LZ4
+    if (w->header.flags & NTSCRS_TRACE_LZ4) {
+        const size_t bound = (size_t)LZ4_compressBound((int)size);
+        if (bound > w->compressed_capacity) {
+            uint8_t *buf = realloc(w->compressed, bound);
+            if (!buf) return false;
+            w->compressed = buf;
+            w->compressed_capacity = bound;
+        }
+
+        const int n = LZ4_compress_default((const char *)data, (char *)w->compressed, (int)size, (int)bound);
+        if (n <= 0) return false;
+        payload = w->compressed;
+        record.payload_size = (uint64_t)n;
+        record.flags |= NTSCRS_TRACE_LZ4;
+    }
+#endif
+
+    const uint64_t record_offset = w->offset;
+    if (!write_bytes(w, &record, sizeof(record)) || !write_padding(w) ||
+        !write_bytes(w, payload, (size_t)record.payload_size) || !write_padding(w)) {
+        return false;
+    }
+
+    w->index[w->header.frame_count++] = record_offset;
+    return true;
+}
+
+uint64_t ntscrs_trace_writer_frame_count(const struct ntscrs_trace_writer *w) {
+    return w->header.frame_count;
+}
+
+bool ntscrs_trace_writer_close(struct ntscrs_trace_writer *w) {
+    if (!w) return false;
+
+    w->header.index_offset = w->offset;
+    bool ok = write_bytes(w, w->index, (size_t)w->header.frame_count * sizeof(*w->index));
+
+    rewind(w->file);
+    ok = ok && fwrite(&w->header, 1, sizeof(w->header), w->file) == sizeof(w->header);
+    ok = (fclose(w->file) == 0) && ok;
+
+    free(w->compressed);
+    free(w->index);
+    free(w);
+    return ok;
+}
+
+/*
+ * Reading
+ */
+
+static bool map_file(struct ntscrs_trace *t, const char *path) {
+#ifdef _WIN32
+    // no mmap here; read the whole file instead
+    FILE *f = fopen(path, "rb");
+    if (!f) return false;
+
+    _fseeki64(f, 0, SEEK_END);
+    const long long size = _ftelli64(f);
+    rewind(f);
+
+    uint8_t *buf = size > 0 ? malloc((size_t)size) : NULL;
+    if (!buf || fread(buf, 1, (size_t)size, f) != (size_t)size) {
+        free(buf);
+        fclose(f);
+        return false;
+    }
+    fclose(f);
+
+    t->base = buf;
+    t->size = (size_t)size;
+    t->mapping = buf;
+    return true;
+#else
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) return false;
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size <= 0) {
+        close(fd);
+        return false;
+    }
+
+    void *base = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (base == MAP_FAILED) return false;
+
+    t->base = base;
+    t->size = (size_t)st.st_size;
+    t->mapping = base;
+    return true;
+#endif
+}
+
+bool ntscrs_trace_open(struct ntscrs_trace *t, const char *path) {
+    memset(t, 0, sizeof(*t));
+    if (!map_file(t, path)) return false;
+
+    const struct ntscrs_trace_header *h = (const struct ntscrs_trace_header *)t->base;
+    if (t->size < sizeof(*h) || memcmp(h->magic, NTSCRS_TRACE_MAGIC, sizeof(h->magic)) != 0 ||
+        h->version != NTSCRS_TRACE_VERSION || h->params_size != sizeof(NtscRsEffectParams) ||
+        h->index_offset > t->size || h->frame_count > (t->size - h->index_offset) / sizeof(uint64_t)) {
+        ntscrs_trace_close(t);
+        return false;
+    }
+
+    t->header = h;
+    t->index = (const uint64_t *)(t->base + h->index_offset);
+    return true;
+}
+
+void ntscrs_trace_close(struct ntscrs_trace *t) {
+    if (t->mapping) {
+#ifdef _WIN32
+        free(t->mapping);
+#else
+        munmap(t->mapping, t->size);
+#endif
+    }
+    memset(t, 0, sizeof(*t));
+}
+
+const uint8_t *ntscrs_trace_frame(const struct ntscrs_trace *t, uint64_t i, const struct ntscrs_trace_record **record,
+                                  uint8_t *scratch, size_t scratch_size) {
+    if (i >= t->header->frame_count) return NULL;
+
+    const uint64_t offset = t->index[i];
+    if (offset > t->size || t->size - offset < sizeof(struct ntscrs_trace_record)) return NULL;
+
+    const struct ntscrs_trace_record *r = (const struct ntscrs_trace_record *)(t->base + offset);
+    const uint64_t payload_offset = align_up(offset + sizeof(*r));
+    if (payload_offset > t->size || t->size - payload_offset < r->payload_size) return NULL;
+
+    const uint8_t *payload = t->base + payload_offset;
+    *record = r;
+
+    if (!(r->flags & NTSCRS_TRACE_LZ4)) {
+        return r->raw_size == r->payload_size ? payload : NULL;
+    }
+
+#ifdef NTSCRS_TRACE_HAVE_LZ4
+    if (r->raw_size > scratch_size) return NULL;
+    const int n = LZ4_decompress_safe((const char *)payload, (char *)scratch, (int)r->payload_size, (int)scratch_size);
+    return (n >= 0 && (uint64_t)n == r->raw_size) ? scratch : NULL;
+#else
+    (void)scratch;
+    (void)scratch_size;
+    return NULL;
+#endif
+}
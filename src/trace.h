@@ -0,0 +1,107 @@
+/*
+ntsc-rs-obs
+Copyright (C) 2025 eigenpunk
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along
+with this program. If not, see <https://www.gnu.org/licenses/>
+*/
+
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#include <ntscrs.h>
+
+// Trace files hold real input frames together with the parameters and frame
+// number they were processed with, so that a capture from a live setup can be
+// replayed through the effect offline. Layout:
+//
+//   header | record, payload | record, payload | ... | index
+//
+// Records and payloads start on NTSCRS_TRACE_ALIGN boundaries so that an
+// uncompressed payload can be used in place from a memory-mapped file. The
+// index is an array of frame_count record offsets, written on close.
+//
+// Parameters are stored as the raw NtscRsEffectParams struct, so a trace is
+// only meant to be replayed by a build with the same ntscrs.h.
+
+#define NTSCRS_TRACE_MAGIC "NTSCTRCE"
+#define NTSCRS_TRACE_VERSION 1
+#define NTSCRS_TRACE_ALIGN 64
+
+#define NTSCRS_TRACE_LZ4 (1u << 0)
+
+struct ntscrs_trace_header {
+    char magic[8];
+    uint32_t version;
+    uint32_t params_size;
+    uint32_t width;
+    uint32_t height;
+    uint32_t pix_fmt;
+    uint32_t bytes_per_pixel;
+    uint32_t flags;
+    uint32_t reserved;
+    uint64_t frame_count;
+    uint64_t index_offset;
+};
+
+struct ntscrs_trace_record {
+    uint64_t frame_num;
+    uint64_t payload_size; // bytes stored after the record
+    uint64_t raw_size;     // bytes after decompression
+    uint32_t flags;
+    uint32_t reserved;
+    NtscRsEffectParams params;
+};
+
+/*
+ * Writing
+ */
+
+struct ntscrs_trace_writer;
+
+// Takes ownership of file. compress is ignored when built without LZ4.
+struct ntscrs_trace_writer *ntscrs_trace_writer_create(FILE *file, uint32_t width, uint32_t height,
+                                                       NtscRsPixelFormat pix_fmt, uint32_t bytes_per_pixel,
+                                                       bool compress);
+bool ntscrs_trace_write_frame(struct ntscrs_trace_writer *w, const NtscRsEffectParams *params, uint64_t frame_num,
+                              const uint8_t *data, size_t size);
+uint64_t ntscrs_trace_writer_frame_count(const struct ntscrs_trace_writer *w);
+
+// Writes the index, finalizes the header and closes the file.
+bool ntscrs_trace_writer_close(struct ntscrs_trace_writer *w);
+
+/*
+ * Reading
+ */
+
+struct ntscrs_trace {
+    const uint8_t *base;
+    size_t size;
+    const struct ntscrs_trace_header *header;
+    const uint64_t *index;
+
+    void *mapping;
+};
+
+bool ntscrs_trace_open(struct ntscrs_trace *t, const char *path);
+void ntscrs_trace_close(struct ntscrs_trace *t);
+
+// Returns the record for frame i and a pointer to its raw pixels: either
+// directly into the mapping, or decompressed into scratch (which must hold
+// raw_size bytes). Returns NULL on a corrupt or unsupported record.
+const uint8_t *ntscrs_trace_frame(const struct ntscrs_trace *t, uint64_t i, const struct ntscrs_trace_record **record,
+                                  uint8_t *scratch, size_t scratch_size);
@@ -0,0 +1,153 @@
+/*
+ntsc-rs-obs
+Copyright (C) 2025 eigenpunk
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along
+with this program. If not, see <https://www.gnu.org/licenses/>
+*/
+
+#include <string.h>
+
+#include <obs-module.h>
+#include <util/platform.h>
+
+#include "plugin-support.h"
+#include "upload-ring.h"
+
+// uploads timed with each method before settling on one
+#define UPLOAD_PROBE_UPLOADS 30
+
+// uploads between two log lines; a minute at 60 fps
+#define UPLOAD_LOG_INTERVAL 3600
+
+enum upload_method {
+    UPLOAD_MAP,
+    UPLOAD_SET_IMAGE,
+    UPLOAD_METHOD_COUNT,
+};
+
+static const char *upload_method_names[UPLOAD_METHOD_COUNT] = {"map", "set_image"};
+
+struct upload_method_stats {
+    uint64_t uploads;
+    uint64_t total_ns;
+    uint64_t max_ns;
+};
+
+// only touched from the graphics thread
+static struct {
+    struct upload_method_stats method[UPLOAD_METHOD_COUNT];
+    bool decided;
+    enum upload_method chosen;
+    uint64_t probed;
+} upload_stats;
+
+static const char *backend_name(void) {
+    switch (gs_get_device_type()) {
+    case GS_DEVICE_OPENGL:
+        return "OpenGL";
+    case GS_DEVICE_DIRECT3D_11:
+        return "Direct3D 11";
+    default:
+        return "unknown backend";
+    }
+}
+
+static double mean_ms(const struct upload_method_stats *s) {
+    return s->uploads ? (double)s->total_ns / (double)s->uploads / 1e6 : 0.0;
+}
+
+static enum upload_method next_method(void) {
+    if (upload_stats.decided) return upload_stats.chosen;
+    return (enum upload_method)(upload_stats.probed % UPLOAD_METHOD_COUNT);
+}
+
+static void record(enum upload_method method, uint64_t ns) {
+    struct upload_method_stats *s = &upload_stats.method[method];
+    s->uploads++;
+    s->total_ns += ns;
+    if (ns > s->max_ns) s->max_ns = ns;
+
+    if (!upload_stats.decided) {
+        if (++upload_stats.probed < (uint64_t)UPLOAD_PROBE_UPLOADS * UPLOAD_METHOD_COUNT) return;
+
+        const struct upload_method_stats *m = &upload_stats.method[UPLOAD_MAP];
+        const struct upload_method_stats *si = &upload_stats.method[UPLOAD_SET_IMAGE];
+        upload_stats.chosen = mean_ms(si) < mean_ms(m) ? UPLOAD_SET_IMAGE : UPLOAD_MAP;
+        upload_stats.decided = true;
+        obs_log(LOG_INFO, "upload (%s): map %.3f ms, set_image %.3f ms on average, using %s", backend_name(),
+                mean_ms(m), mean_ms(si), upload_method_names[upload_stats.chosen]);
+        memset(upload_stats.method, 0, sizeof(upload_stats.method));
+        return;
+    }
+
+    if (s->uploads >= UPLOAD_LOG_INTERVAL) {
+        obs_log(LOG_INFO, "upload (%s, %s): %.3f ms average, %.3f ms max over %llu frames", backend_name(),
+                upload_method_names[method], mean_ms(s), (double)s->max_ns / 1e6, (unsigned long long)s->uploads);
+        memset(s, 0, sizeof(*s));
+    }
+}
+
+bool upload_ring_create(struct upload_ring *ring, uint32_t cx, uint32_t cy, enum gs_color_format format) {
+    memset(ring, 0, sizeof(*ring));
+    for (size_t i = 0; i < UPLOAD_RING_SIZE; i++) {
+        gs_texture_t *tex = gs_texture_create(cx, cy, format, 1, NULL, GS_DYNAMIC);
+        if (!tex) break;
+        ring->tex[ring->count++] = tex;
+    }
+    // a shorter ring still works, it just may wait on the GPU more often
+    return ring->count > 0;
+}
+
+void upload_ring_destroy(struct upload_ring *ring) {
+    for (size_t i = 0; i < ring->count; i++)
+        gs_texture_destroy(ring->tex[i]);
+    memset(ring, 0, sizeof(*ring));
+}
+
+static bool write_mapped(gs_texture_t *tex, const uint8_t *data, uint32_t linesize) {
+    uint8_t *ptr;
+    uint32_t tex_linesize;
+    if (!gs_texture_map(tex, &ptr, &tex_linesize)) return false;
+
+    const uint32_t h = gs_texture_get_height(tex);
+    if (tex_linesize == linesize) {
+        memcpy(ptr, data, (size_t)linesize * h);
+    } else {
+        // rows may be padded
+        const uint32_t row = linesize < tex_linesize ? linesize : tex_linesize;
+        for (uint32_t y = 0; y < h; y++)
+            memcpy(ptr + (size_t)y * tex_linesize, data + (size_t)y * linesize, row);
+    }
+    gs_texture_unmap(tex);
+    return true;
+}
+
+bool upload_ring_write(struct upload_ring *ring, const uint8_t *data, uint32_t linesize) {
+    if (!ring->count) return false;
+
+    const size_t next = (ring->current + 1) % ring->count;
+    gs_texture_t *tex = ring->tex[next];
+    const enum upload_method method = next_method();
+
+    const uint64_t start = os_gettime_ns();
+    if (method == UPLOAD_SET_IMAGE) {
+        gs_texture_set_image(tex, data, linesize, false);
+    } else if (!write_mapped(tex, data, linesize)) {
+        return false;
+    }
+    record(method, os_gettime_ns() - start);
+
+    ring->current = next;
+    return true;
+}
@@ -0,0 +1,56 @@
+/*
+ntsc-rs-obs
+Copyright (C) 2025 eigenpunk
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along
+with this program. If not, see <https://www.gnu.org/licenses/>
+*/
+
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include <graphics/graphics.h>
+
+// Textures the processed frame is uploaded into. Each frame goes into the
+// next texture in the ring, so it's never one the GPU may still be drawing
+// from for an earlier frame, which on some drivers makes gs_texture_map wait.
+//
+// A frame can be uploaded by mapping the texture and copying into it, or
+// with gs_texture_set_image. Which one is cheaper depends on the graphics
+// backend and driver, so the first uploads alternate between them and the
+// faster one is used from then on. Upload times are kept per method for the
+// whole module (there is one graphics backend per process) and logged
+// periodically.
+
+#define UPLOAD_RING_SIZE 3
+
+struct upload_ring {
+    gs_texture_t *tex[UPLOAD_RING_SIZE];
+    size_t count;
+    size_t current; // most recently written, the one to draw
+};
+
+// Must be called inside the graphics context, as must destroy and write.
+bool upload_ring_create(struct upload_ring *ring, uint32_t cx, uint32_t cy, enum gs_color_format format);
+void upload_ring_destroy(struct upload_ring *ring);
+
+static inline gs_texture_t *upload_ring_current(const struct upload_ring *ring) {
+    return ring->count ? ring->tex[ring->current] : NULL;
+}
+
+// Writes a frame of linesize-byte rows into the next texture and makes it
+// the current one. On failure the current texture is left as it was.
+bool upload_ring_write(struct upload_ring *ring, const uint8_t *data, uint32_t linesize);
@@ -0,0 +1,196 @@
+/*
+ntsc-rs-obs
+Copyright (C) 2025 eigenpunk
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along
+with this program. If not, see <https://www.gnu.org/licenses/>
+*/
+
+#ifdef __linux__
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+#include <sched.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#elif defined(_WIN32)
+#include <windows.h>
+#elif defined(__APPLE__)
+#include <pthread.h>
+#include <sys/qos.h>
+#endif
+
+#include <string.h>
+
+#include <obs-module.h>
+#include <util/platform.h>
+#include <util/threading.h>
+
+#include <ntscrs.h>
+
+#include "plugin-support.h"
+#include "workers.h"
+#include "perf-counters.h"
+
+#define WORKERS_FILE "workers.json"
+
+// how much unused budget can be saved up for a burst, in seconds' worth
+#define WORKERS_BUDGET_BURST 0.25
+
+// also applies to files written before the setting existed
+#define WORKERS_IDLE_RELEASE_DEFAULT 60
+
+enum worker_policy {
+    WORKER_POLICY_NORMAL,
+    WORKER_POLICY_BATCH,
+    WORKER_POLICY_IDLE,
+};
+
+static const char *policy_names[] = {"normal", "batch", "idle"};
+
+// written once by workers_init before any worker exists
+static enum worker_policy worker_policy;
+static int worker_nice;
+static uint32_t cpu_budget;
+static bool perf_counters;
+static uint32_t idle_release_seconds = WORKERS_IDLE_RELEASE_DEFAULT;
+
+static pthread_mutex_t budget_mutex = PTHREAD_MUTEX_INITIALIZER;
+static int64_t budget_tokens_ns;
+static uint64_t budget_refill_ts;
+
+static void worker_started(uintptr_t index) {
+    perf_counters_thread_start(index);
+
+#ifdef __linux__
+    if (worker_policy != WORKER_POLICY_NORMAL) {
+        const struct sched_param sp = {.sched_priority = 0};
+        const int policy = worker_policy == WORKER_POLICY_IDLE ? SCHED_IDLE : SCHED_BATCH;
+        pthread_setschedparam(pthread_self(), policy, &sp);
+    }
+    // nice is per thread on Linux
+    if (worker_nice > 0) setpriority(PRIO_PROCESS, (id_t)syscall(SYS_gettid), worker_nice);
+#elif defined(_WIN32)
+    int priority = THREAD_PRIORITY_NORMAL;
+    if (worker_policy == WORKER_POLICY_IDLE || worker_nice >= 15) {
+        priority = THREAD_PRIORITY_IDLE;
+    } else if (worker_policy == WORKER_POLICY_BATCH || worker_nice >= 10) {
+        priority = THREAD_PRIORITY_LOWEST;
+    } else if (worker_nice > 0) {
+        priority = THREAD_PRIORITY_BELOW_NORMAL;
+    }
+    if (priority != THREAD_PRIORITY_NORMAL) SetThreadPriority(GetCurrentThread(), priority);
+#elif defined(__APPLE__)
+    if (worker_policy == WORKER_POLICY_IDLE || worker_nice >= 15) {
+        pthread_set_qos_class_self_np(QOS_CLASS_BACKGROUND, 0);
+    } else if (worker_policy == WORKER_POLICY_BATCH || worker_nice > 0) {
+        pthread_set_qos_class_self_np(QOS_CLASS_UTILITY, 0);
+    }
+#endif
+}
+
+static void load_settings(void) {
+    char *path = obs_module_config_path(WORKERS_FILE);
+    if (!path) return;
+
+    obs_data_t *data = obs_data_create_from_json_file_safe(path, "bak");
+    if (data) {
+        const char *policy = obs_data_get_string(data, "worker_policy");
+        for (size_t i = 0; i < OBS_COUNTOF(policy_names); i++) {
+            if (strcmp(policy, policy_names[i]) == 0) worker_policy = (enum worker_policy)i;
+        }
+        const long long nice = obs_data_get_int(data, "worker_nice");
+        worker_nice = nice < 0 ? 0 : nice > 19 ? 19 : (int)nice;
+        const long long budget = obs_data_get_int(data, "cpu_budget_percent");
+        cpu_budget = budget < 0 ? 0 : (uint32_t)budget;
+        perf_counters = obs_data_get_bool(data, "perf_counters");
+        obs_data_set_default_int(data, "idle_release_seconds", WORKERS_IDLE_RELEASE_DEFAULT);
+        const long long idle = obs_data_get_int(data, "idle_release_seconds");
+        idle_release_seconds = idle < 0 ? 0 : (uint32_t)idle;
+    } else {
+        // leave a file with the defaults for people to find and edit
+        char *dir = obs_module_config_path("");
+        if (dir) os_mkdirs(dir);
+        bfree(dir);
+
+        data = obs_data_create();
+        obs_data_set_string(data, "worker_policy", policy_names[WORKER_POLICY_NORMAL]);
+        obs_data_set_int(data, "worker_nice", 0);
+        obs_data_set_int(data, "cpu_budget_percent", 0);
+        obs_data_set_bool(data, "perf_counters", false);
+        obs_data_set_int(data, "idle_release_seconds", WORKERS_IDLE_RELEASE_DEFAULT);
+        obs_data_save_json_safe(data, path, "tmp", "bak");
+    }
+
+    obs_data_release(data);
+    bfree(path);
+}
+
+void workers_init(void) {
+    load_settings();
+    if (perf_counters) perf_counters_enable();
+
+    // counters are opened by the workers themselves, so they need the
+    // handler too
+    if (worker_policy != WORKER_POLICY_NORMAL || worker_nice > 0 || perf_counters) {
+        if (!ntscrs_set_worker_start_handler(worker_started)) {
+            obs_log(LOG_WARNING, "workers: could not recreate the worker pool");
+        }
+    }
+
+    budget_tokens_ns = (int64_t)(WORKERS_BUDGET_BURST * cpu_budget * 1e7);
+    budget_refill_ts = os_gettime_ns();
+
+    if (cpu_budget) {
+        obs_log(LOG_INFO, "workers: policy %s, nice %d, CPU budget %u%% of one core", policy_names[worker_policy],
+                worker_nice, cpu_budget);
+    } else {
+        obs_log(LOG_INFO, "workers: policy %s, nice %d, no CPU budget", policy_names[worker_policy], worker_nice);
+    }
+}
+
+uint32_t workers_cpu_budget(void) {
+    return cpu_budget;
+}
+
+uint64_t workers_idle_release_ns(void) {
+    return idle_release_seconds * 1000000000ULL;
+}
+
+bool workers_budget_allows(void) {
+    if (!cpu_budget) return true;
+
+    pthread_mutex_lock(&budget_mutex);
+    const uint64_t now = os_gettime_ns();
+    const int64_t capacity = (int64_t)(WORKERS_BUDGET_BURST * cpu_budget * 1e7);
+    budget_tokens_ns += (int64_t)((now - budget_refill_ts) * cpu_budget / 100);
+    if (budget_tokens_ns > capacity) budget_tokens_ns = capacity;
+    budget_refill_ts = now;
+    const bool allows = budget_tokens_ns > 0;
+    pthread_mutex_unlock(&budget_mutex);
+    return allows;
+}
+
+uint64_t workers_budget_charge(uint64_t wall_ns) {
+    // the render thread waits while the workers run, so every worker is
+    // counted as busy for the whole pass; this overestimates a little when
+    // stages leave workers idle
+    const uint64_t cpu_ns = wall_ns * ntscrs_thread_count();
+    if (!cpu_budget) return cpu_ns;
+
+    pthread_mutex_lock(&budget_mutex);
+    budget_tokens_ns -= (int64_t)cpu_ns;
+    pthread_mutex_unlock(&budget_mutex);
+    return cpu_ns;
+}
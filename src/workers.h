@@ -0,0 +1,60 @@
+/*
+ntsc-rs-obs
+Copyright (C) 2025 eigenpunk
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along
+with this program. If not, see <https://www.gnu.org/licenses/>
+*/
+
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// Module-wide limits that keep the effect from competing with the game and
+// the encoder on single-PC setups. They are read from workers.json in the
+// module config directory, which is written with the defaults on first load:
+//
+//   "worker_policy":      "normal", "batch" or "idle"; batch and idle are
+//                         Linux scheduling classes, elsewhere they map to
+//                         the closest lower thread priority
+//   "worker_nice":        0 to 19, applied to every effect worker thread
+//   "cpu_budget_percent": CPU time all filters together may spend on the
+//                         effect, in percent of one core; 0 is unlimited
+//   "perf_counters":      true to log hardware counters for the effect
+//                         (Linux only, see perf-counters.h)
+//   "idle_release_seconds": how long a filter may go without rendering
+//                         before it releases its textures and buffers
+//                         (default 60); 0 keeps them for as long as the
+//                         filter exists
+//
+// When the budget is used up, filters show their previous output instead of
+// processing a new frame.
+
+// loads the settings and applies the worker priority; call from
+// obs_module_load before anything resizes the worker pool
+void workers_init(void);
+
+// percent of one core, 0 if unlimited
+uint32_t workers_cpu_budget(void);
+
+// how long a filter may go without rendering before it releases its
+// buffers, 0 if never
+uint64_t workers_idle_release_ns(void);
+
+// whether there is budget left for processing a frame now
+bool workers_budget_allows(void);
+
+// charges an effect pass that took wall_ns; returns the CPU time it's
+// counted as
+uint64_t workers_budget_charge(uint64_t wall_ns);
@@ -0,0 +1,908 @@
+/*
+ntsc-rs-obs
+Copyright (C) 2025 eigenpunk
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along
+with this program. If not, see <https://www.gnu.org/licenses/>
+*/
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <obs-module.h>
+#include <util/base.h>
+#include <util/platform.h>
+#include <util/threading.h>
+
+#include "mock-obs.h"
+#include "tool-common.h"
+
+struct mock_stats mock_stats;
+int mock_log_level = LOG_INFO;
+
+/*
+ * MEMORY, LOGGING, PLATFORM
+ */
+
+void *bmalloc(size_t size) {
+    // libobs never returns NULL from bmalloc, and neither do we
+    void *ptr = malloc(size ? size : 1);
+    if (!ptr) abort();
+    return ptr;
+}
+
+void *brealloc(void *ptr, size_t size) {
+    ptr = realloc(ptr, size ? size : 1);
+    if (!ptr) abort();
+    return ptr;
+}
+
+void bfree(void *ptr) {
+    free(ptr);
+}
+
+void blogva(int log_level, const char *format, va_list args) {
+    if (log_level > mock_log_level) return;
+    vfprintf(stderr, format, args);
+    fputc('\n', stderr);
+}
+
+void blog(int log_level, const char *format, ...) {
+    va_list args;
+    va_start(args, format);
+    blogva(log_level, format, args);
+    va_end(args);
+}
+
+FILE *os_fopen(const char *path, const char *mode) {
+    return path ? fopen(path, mode) : NULL;
+}
+
+uint64_t os_gettime_ns(void) {
+    return tool_now_ns();
+}
+
+int os_get_logical_cores(void) {
+    return (int)sysconf(_SC_NPROCESSORS_ONLN);
+}
+
+int os_get_physical_cores(void) {
+    return os_get_logical_cores();
+}
+
+int os_mkdirs(const char *path) {
+    UNUSED_PARAMETER(path);
+    return MKDIR_ERROR;
+}
+
+void os_set_thread_name(const char *name) {
+    UNUSED_PARAMETER(name);
+}
+
+// no config directory, so nothing is loaded or persisted
+char *obs_module_get_config_path(obs_module_t *module, const char *file) {
+    UNUSED_PARAMETER(module);
+    UNUSED_PARAMETER(file);
+    return NULL;
+}
+
+bool text_lookup_getstr(lookup_t *lookup, const char *lookup_val, const char **out) {
+    UNUSED_PARAMETER(lookup);
+    UNUSED_PARAMETER(lookup_val);
+    UNUSED_PARAMETER(out);
+    return false;
+}
+
+void text_lookup_destroy(lookup_t *lookup) {
+    UNUSED_PARAMETER(lookup);
+}
+
+lookup_t *obs_module_load_locale(obs_module_t *module, const char *default_locale, const char *locale) {
+    UNUSED_PARAMETER(module);
+    UNUSED_PARAMETER(default_locale);
+    UNUSED_PARAMETER(locale);
+    return NULL;
+}
+
+/*
+ * OBS_DATA
+ */
+
+enum mock_data_type { MOCK_DATA_NUM, MOCK_DATA_BOOL, MOCK_DATA_STRING };
+
+struct mock_data_value {
+    long long i;
+    double d;
+    bool b;
+    char *s;
+};
+
+struct mock_data_item {
+    char *name;
+    enum mock_data_type type;
+    bool has_user, has_default;
+    struct mock_data_value user, def;
+};
+
+struct obs_data {
+    struct mock_data_item *items;
+    size_t count, capacity;
+};
+
+obs_data_t *obs_data_create(void) {
+    return bzalloc(sizeof(obs_data_t));
+}
+
+void obs_data_release(obs_data_t *data) {
+    if (!data) return;
+    for (size_t i = 0; i < data->count; i++) {
+        bfree(data->items[i].name);
+        bfree(data->items[i].user.s);
+        bfree(data->items[i].def.s);
+    }
+    bfree(data->items);
+    bfree(data);
+}
+
+static struct mock_data_item *data_find(obs_data_t *data, const char *name) {
+    for (size_t i = 0; i < data->count; i++) {
+        if (strcmp(data->items[i].name, name) == 0) return &data->items[i];
+    }
+    return NULL;
+}
+
+static struct mock_data_item *data_get_or_add(obs_data_t *data, const char *name, enum mock_data_type type) {
+    struct mock_data_item *item = data_find(data, name);
+    if (!item) {
+        if (data->count == data->capacity) {
+            data->capacity = data->capacity ? data->capacity * 2 : 64;
+            data->items = brealloc(data->items, data->capacity * sizeof(*data->items));
+        }
+        item = &data->items[data->count++];
+        memset(item, 0, sizeof(*item));
+        item->name = bstrdup(name);
+    }
+    item->type = type;
+    return item;
+}
+
+static const struct mock_data_value *data_value(obs_data_t *data, const char *name) {
+    const struct mock_data_item *item = data ? data_find(data, name) : NULL;
+    if (!item) return NULL;
+    if (item->has_user) return &item->user;
+    if (item->has_default) return &item->def;
+    return NULL;
+}
+
+static void data_set_num(obs_data_t *data, const char *name, long long i, double d, bool is_default) {
+    struct mock_data_item *item = data_get_or_add(data, name, MOCK_DATA_NUM);
+    struct mock_data_value *v = is_default ? &item->def : &item->user;
+    v->i = i;
+    v->d = d;
+    *(is_default ? &item->has_default : &item->has_user) = true;
+}
+
+static void data_set_bool(obs_data_t *data, const char *name, bool b, bool is_default) {
+    struct mock_data_item *item = data_get_or_add(data, name, MOCK_DATA_BOOL);
+    (is_default ? &item->def : &item->user)->b = b;
+    *(is_default ? &item->has_default : &item->has_user) = true;
+}
+
+static void data_set_string(obs_data_t *data, const char *name, const char *s, bool is_default) {
+    struct mock_data_item *item = data_get_or_add(data, name, MOCK_DATA_STRING);
+    struct mock_data_value *v = is_default ? &item->def : &item->user;
+    bfree(v->s);
+    v->s = bstrdup(s ? s : "");
+    *(is_default ? &item->has_default : &item->has_user) = true;
+}
+
+void obs_data_set_int(obs_data_t *data, const char *name, long long val) {
+    data_set_num(data, name, val, (double)val, false);
+}
+
+void obs_data_set_double(obs_data_t *data, const char *name, double val) {
+    data_set_num(data, name, (long long)val, val, false);
+}
+
+void obs_data_set_bool(obs_data_t *data, const char *name, bool val) {
+    data_set_bool(data, name, val, false);
+}
+
+void obs_data_set_string(obs_data_t *data, const char *name, const char *val) {
+    data_set_string(data, name, val, false);
+}
+
+void obs_data_set_default_int(obs_data_t *data, const char *name, long long val) {
+    data_set_num(data, name, val, (double)val, true);
+}
+
+void obs_data_set_default_double(obs_data_t *data, const char *name, double val) {
+    data_set_num(data, name, (long long)val, val, true);
+}
+
+void obs_data_set_default_bool(obs_data_t *data, const char *name, bool val) {
+    data_set_bool(data, name, val, true);
+}
+
+void obs_data_set_default_string(obs_data_t *data, const char *name, const char *val) {
+    data_set_string(data, name, val, true);
+}
+
+long long obs_data_get_int(obs_data_t *data, const char *name) {
+    const struct mock_data_value *v = data_value(data, name);
+    return v ? v->i : 0;
+}
+
+double obs_data_get_double(obs_data_t *data, const char *name) {
+    const struct mock_data_value *v = data_value(data, name);
+    return v ? v->d : 0.0;
+}
+
+bool obs_data_get_bool(obs_data_t *data, const char *name) {
+    const struct mock_data_value *v = data_value(data, name);
+    return v ? v->b : false;
+}
+
+const char *obs_data_get_string(obs_data_t *data, const char *name) {
+    const struct mock_data_value *v = data_value(data, name);
+    return v && v->s ? v->s : "";
+}
+
+obs_data_t *obs_data_create_from_json_file_safe(const char *json_file, const char *backup_ext) {
+    UNUSED_PARAMETER(json_file);
+    UNUSED_PARAMETER(backup_ext);
+    return NULL;
+}
+
+bool obs_data_save_json_safe(obs_data_t *data, const char *file, const char *temp_ext, const char *backup_ext) {
+    UNUSED_PARAMETER(data);
+    UNUSED_PARAMETER(file);
+    UNUSED_PARAMETER(temp_ext);
+    UNUSED_PARAMETER(backup_ext);
+    return false;
+}
+
+bool obs_data_has_user_value(obs_data_t *data, const char *name) {
+    const struct mock_data_item *item = data ? data_find(data, name) : NULL;
+    return item && item->has_user;
+}
+
+/*
+ * OBS_PROPERTIES
+ */
+
+// properties are only built to make sure get_properties runs; nothing is kept
+struct obs_properties {
+    size_t count;
+};
+
+struct obs_property {
+    int unused;
+};
+
+static obs_property_t dummy_property;
+
+obs_properties_t *obs_properties_create(void) {
+    return bzalloc(sizeof(obs_properties_t));
+}
+
+void obs_properties_destroy(obs_properties_t *props) {
+    bfree(props);
+}
+
+static obs_property_t *add_property(obs_properties_t *props) {
+    props->count++;
+    return &dummy_property;
+}
+
+obs_property_t *obs_properties_add_bool(obs_properties_t *props, const char *name, const char *description) {
+    UNUSED_PARAMETER(name);
+    UNUSED_PARAMETER(description);
+    return add_property(props);
+}
+
+obs_property_t *obs_properties_add_int(obs_properties_t *props, const char *name, const char *description, int min,
+                                       int max, int step) {
+    UNUSED_PARAMETER(name);
+    UNUSED_PARAMETER(description);
+    UNUSED_PARAMETER(min);
+    UNUSED_PARAMETER(max);
+    UNUSED_PARAMETER(step);
+    return add_property(props);
+}
+
+obs_property_t *obs_properties_add_float(obs_properties_t *props, const char *name, const char *description,
+                                         double min, double max, double step) {
+    UNUSED_PARAMETER(name);
+    UNUSED_PARAMETER(description);
+    UNUSED_PARAMETER(min);
+    UNUSED_PARAMETER(max);
+    UNUSED_PARAMETER(step);
+    return add_property(props);
+}
+
+obs_property_t *obs_properties_add_list(obs_properties_t *props, const char *name, const char *description,
+                                        enum obs_combo_type type, enum obs_combo_format format) {
+    UNUSED_PARAMETER(name);
+    UNUSED_PARAMETER(description);
+    UNUSED_PARAMETER(type);
+    UNUSED_PARAMETER(format);
+    return add_property(props);
+}
+
+obs_property_t *obs_properties_add_path(obs_properties_t *props, const char *name, const char *description,
+                                        enum obs_path_type type, const char *filter, const char *default_path) {
+    UNUSED_PARAMETER(name);
+    UNUSED_PARAMETER(description);
+    UNUSED_PARAMETER(type);
+    UNUSED_PARAMETER(filter);
+    UNUSED_PARAMETER(default_path);
+    return add_property(props);
+}
+
+obs_property_t *obs_properties_add_text(obs_properties_t *props, const char *name, const char *description,
+                                        enum obs_text_type type) {
+    UNUSED_PARAMETER(name);
+    UNUSED_PARAMETER(description);
+    UNUSED_PARAMETER(type);
+    return add_property(props);
+}
+
+obs_property_t *obs_properties_add_button(obs_properties_t *props, const char *name, const char *text,
+                                          obs_property_clicked_t callback) {
+    UNUSED_PARAMETER(name);
+    UNUSED_PARAMETER(text);
+    UNUSED_PARAMETER(callback);
+    return add_property(props);
+}
+
+size_t obs_property_list_add_int(obs_property_t *p, const char *name, long long val) {
+    UNUSED_PARAMETER(p);
+    UNUSED_PARAMETER(name);
+    UNUSED_PARAMETER(val);
+    return 0;
+}
+
+void obs_property_set_long_description(obs_property_t *p, const char *long_description) {
+    UNUSED_PARAMETER(p);
+    UNUSED_PARAMETER(long_description);
+}
+
+/*
+ * GRAPHICS
+ */
+
+struct gs_texture {
+    uint32_t width, height, linesize;
+    enum gs_color_format format;
+    uint8_t *data;
+};
+
+struct gs_stage_surface {
+    gs_texture_t tex;
+};
+
+struct gs_texture_render {
+    enum gs_color_format format;
+    gs_texture_t *target;
+    bool rendered;
+};
+
+struct gs_effect {
+    bool looping;
+};
+
+struct gs_effect_param {
+    int unused;
+};
+
+static gs_effect_t default_effect;
+static gs_eparam_t dummy_param;
+
+// stack of bound render targets; the bottom one is the frame's output
+#define MAX_TARGETS 16
+static gs_texture_t *targets[MAX_TARGETS];
+static size_t target_depth;
+
+static inline gs_texture_t *current_target(void) {
+    return target_depth ? targets[target_depth - 1] : NULL;
+}
+
+static void texture_init(gs_texture_t *tex, uint32_t width, uint32_t height, enum gs_color_format format) {
+    tex->width = width;
+    tex->height = height;
+    tex->format = format;
+    tex->linesize = width * (gs_get_format_bpp(format) / 8);
+    tex->data = bzalloc((size_t)tex->linesize * height);
+}
+
+void obs_enter_graphics(void) {}
+void obs_leave_graphics(void) {}
+
+bool obs_get_video_info(struct obs_video_info *ovi) {
+    UNUSED_PARAMETER(ovi);
+    return false;
+}
+
+float obs_get_video_sdr_white_level(void) {
+    return 300.0f;
+}
+
+gs_effect_t *obs_get_base_effect(enum obs_base_effect effect) {
+    UNUSED_PARAMETER(effect);
+    return &default_effect;
+}
+
+enum gs_color_space gs_get_color_space(void) {
+    return GS_CS_SRGB;
+}
+
+int gs_get_device_type(void) {
+    return GS_DEVICE_OPENGL;
+}
+
+gs_texture_t *gs_texture_create(uint32_t width, uint32_t height, enum gs_color_format color_format, uint32_t levels,
+                                const uint8_t **data, uint32_t flags) {
+    UNUSED_PARAMETER(levels);
+    UNUSED_PARAMETER(flags);
+    gs_texture_t *tex = bzalloc(sizeof(gs_texture_t));
+    texture_init(tex, width, height, color_format);
+    if (data && data[0]) {
+        memcpy(tex->data, data[0], (size_t)tex->linesize * height);
+    }
+    return tex;
+}
+
+void gs_texture_destroy(gs_texture_t *tex) {
+    if (!tex) return;
+    bfree(tex->data);
+    bfree(tex);
+}
+
+uint32_t gs_texture_get_width(const gs_texture_t *tex) {
+    return tex->width;
+}
+
+uint32_t gs_texture_get_height(const gs_texture_t *tex) {
+    return tex->height;
+}
+
+bool gs_texture_map(gs_texture_t *tex, uint8_t **ptr, uint32_t *linesize) {
+    *ptr = tex->data;
+    *linesize = tex->linesize;
+    return true;
+}
+
+void gs_texture_unmap(gs_texture_t *tex) {
+    mock_stats.upload_bytes += (uint64_t)tex->linesize * tex->height;
+}
+
+void gs_texture_set_image(gs_texture_t *tex, const uint8_t *data, uint32_t linesize, bool invert) {
+    UNUSED_PARAMETER(invert);
+    const uint32_t row = linesize < tex->linesize ? linesize : tex->linesize;
+    for (uint32_t y = 0; y < tex->height; y++) {
+        memcpy(tex->data + (size_t)y * tex->linesize, data + (size_t)y * linesize, row);
+    }
+    mock_stats.upload_bytes += (uint64_t)tex->linesize * tex->height;
+}
+
+gs_stagesurf_t *gs_stagesurface_create(uint32_t width, uint32_t height, enum gs_color_format color_format) {
+    gs_stagesurf_t *surf = bzalloc(sizeof(gs_stagesurf_t));
+    texture_init(&surf->tex, width, height, color_format);
+    return surf;
+}
+
+void gs_stagesurface_destroy(gs_stagesurf_t *stagesurf) {
+    if (!stagesurf) return;
+    bfree(stagesurf->tex.data);
+    bfree(stagesurf);
+}
+
+uint32_t gs_stagesurface_get_width(const gs_stagesurf_t *stagesurf) {
+    return stagesurf->tex.width;
+}
+
+uint32_t gs_stagesurface_get_height(const gs_stagesurf_t *stagesurf) {
+    return stagesurf->tex.height;
+}
+
+void gs_stage_texture(gs_stagesurf_t *dst, gs_texture_t *src) {
+    if (!src || src->format != dst->tex.format) return;
+
+    // a GPU-side copy in real life
+    const uint64_t start = tool_now_ns();
+    const uint32_t h = src->height < dst->tex.height ? src->height : dst->tex.height;
+    const uint32_t row = src->linesize < dst->tex.linesize ? src->linesize : dst->tex.linesize;
+    for (uint32_t y = 0; y < h; y++) {
+        memcpy(dst->tex.data + (size_t)y * dst->tex.linesize, src->data + (size_t)y * src->linesize, row);
+    }
+    mock_stats.gpu_ns += tool_now_ns() - start;
+}
+
+bool gs_stagesurface_map(gs_stagesurf_t *stagesurf, uint8_t **data, uint32_t *linesize) {
+    *data = stagesurf->tex.data;
+    *linesize = stagesurf->tex.linesize;
+    mock_stats.readback_bytes += (uint64_t)stagesurf->tex.linesize * stagesurf->tex.height;
+    return true;
+}
+
+void gs_stagesurface_unmap(gs_stagesurf_t *stagesurf) {
+    UNUSED_PARAMETER(stagesurf);
+}
+
+gs_texrender_t *gs_texrender_create(enum gs_color_format format, enum gs_zstencil_format zsformat) {
+    UNUSED_PARAMETER(zsformat);
+    gs_texrender_t *tr = bzalloc(sizeof(gs_texrender_t));
+    tr->format = format;
+    return tr;
+}
+
+void gs_texrender_destroy(gs_texrender_t *texrender) {
+    if (!texrender) return;
+    gs_texture_destroy(texrender->target);
+    bfree(texrender);
+}
+
+bool gs_texrender_begin_with_color_space(gs_texrender_t *texrender, uint32_t cx, uint32_t cy,
+                                         enum gs_color_space space) {
+    UNUSED_PARAMETER(space);
+    if (texrender->rendered || target_depth == MAX_TARGETS || !cx || !cy) return false;
+
+    gs_texture_t *t = texrender->target;
+    if (!t || t->width != cx || t->height != cy) {
+        gs_texture_destroy(t);
+        texrender->target = t = gs_texture_create(cx, cy, texrender->format, 1, NULL, GS_RENDER_TARGET);
+    }
+    targets[target_depth++] = t;
+    return true;
+}
+
+void gs_texrender_end(gs_texrender_t *texrender) {
+    if (target_depth) target_depth--;
+    texrender->rendered = true;
+}
+
+void gs_texrender_reset(gs_texrender_t *texrender) {
+    if (texrender) texrender->rendered = false;
+}
+
+gs_texture_t *gs_texrender_get_texture(const gs_texrender_t *texrender) {
+    return texrender ? texrender->target : NULL;
+}
+
+enum gs_color_format gs_texrender_get_format(const gs_texrender_t *texrender) {
+    return texrender->format;
+}
+
+void gs_blend_state_push(void) {}
+void gs_blend_state_pop(void) {}
+
+void gs_blend_function(enum gs_blend_type src, enum gs_blend_type dest) {
+    UNUSED_PARAMETER(src);
+    UNUSED_PARAMETER(dest);
+}
+
+void gs_clear(uint32_t clear_flags, const struct vec4 *color, float depth, uint8_t stencil) {
+    UNUSED_PARAMETER(color);
+    UNUSED_PARAMETER(depth);
+    UNUSED_PARAMETER(stencil);
+    gs_texture_t *t = current_target();
+    if (t && (clear_flags & GS_CLEAR_COLOR)) {
+        const uint64_t start = tool_now_ns();
+        memset(t->data, 0, (size_t)t->linesize * t->height);
+        mock_stats.gpu_ns += tool_now_ns() - start;
+    }
+}
+
+void gs_ortho(float left, float right, float top, float bottom, float znear, float zfar) {
+    UNUSED_PARAMETER(left);
+    UNUSED_PARAMETER(right);
+    UNUSED_PARAMETER(top);
+    UNUSED_PARAMETER(bottom);
+    UNUSED_PARAMETER(znear);
+    UNUSED_PARAMETER(zfar);
+}
+
+gs_eparam_t *gs_effect_get_param_by_name(const gs_effect_t *effect, const char *name) {
+    UNUSED_PARAMETER(effect);
+    UNUSED_PARAMETER(name);
+    return &dummy_param;
+}
+
+void gs_effect_set_texture(gs_eparam_t *param, gs_texture_t *val) {
+    UNUSED_PARAMETER(param);
+    UNUSED_PARAMETER(val);
+}
+
+void gs_effect_set_float(gs_eparam_t *param, float val) {
+    UNUSED_PARAMETER(param);
+    UNUSED_PARAMETER(val);
+}
+
+// one pass per technique
+bool gs_effect_loop(gs_effect_t *effect, const char *name) {
+    UNUSED_PARAMETER(name);
+    effect->looping = !effect->looping;
+    return effect->looping;
+}
+
+// copies into the bound target so that a filter above sees this output
+void gs_draw_sprite(gs_texture_t *tex, uint32_t flip, uint32_t width, uint32_t height) {
+    UNUSED_PARAMETER(flip);
+    mock_stats.draws++;
+
+    gs_texture_t *t = current_target();
+    if (!tex || !t || t->format != tex->format) return;
+
+    const uint64_t start = tool_now_ns();
+    const uint32_t w = width < tex->width ? width : tex->width;
+    const uint32_t h = height < tex->height ? height : tex->height;
+    const size_t bytes_per_pixel = gs_get_format_bpp(t->format) / 8;
+    const size_t row = (size_t)(w < t->width ? w : t->width) * bytes_per_pixel;
+    for (uint32_t y = 0; y < h && y < t->height; y++) {
+        memcpy(t->data + (size_t)y * t->linesize, tex->data + (size_t)y * tex->linesize, row);
+    }
+    mock_stats.gpu_ns += tool_now_ns() - start;
+}
+
+/*
+ * SOURCES
+ */
+
+struct obs_source {
+    // NULL for inputs
+    const struct obs_source_info *info;
+    void *data;
+    obs_data_t *settings;
+    obs_source_t *target;
+    obs_source_t *parent;
+    volatile bool update_pending;
+
+    // inputs only
+    uint32_t cx, cy;
+    enum gs_color_space space;
+    enum mock_content content;
+    uint32_t frame;
+    bool active;
+};
+
+#define MAX_SOURCE_TYPES 8
+static struct obs_source_info source_types[MAX_SOURCE_TYPES];
+static size_t source_type_count;
+
+void obs_register_source_s(const struct obs_source_info *info, size_t size) {
+    if (source_type_count == MAX_SOURCE_TYPES) return;
+    struct obs_source_info *dst = &source_types[source_type_count++];
+    memset(dst, 0, sizeof(*dst));
+    memcpy(dst, info, size < sizeof(*dst) ? size : sizeof(*dst));
+}
+
+const struct obs_source_info *mock_load_module(const char *id) {
+    obs_module_set_pointer(NULL);
+    if (!obs_module_load()) return NULL;
+    for (size_t i = 0; i < source_type_count; i++) {
+        if (strcmp(source_types[i].id, id) == 0) return &source_types[i];
+    }
+    return NULL;
+}
+
+void mock_unload_module(void) {
+    obs_module_unload();
+    source_type_count = 0;
+}
+
+obs_source_t *mock_input_create(uint32_t cx, uint32_t cy, enum gs_color_space space, enum mock_content content) {
+    obs_source_t *input = bzalloc(sizeof(obs_source_t));
+    input->cx = cx;
+    input->cy = cy;
+    input->space = space;
+    input->content = content;
+    input->active = true;
+    return input;
+}
+
+void mock_input_resize(obs_source_t *input, uint32_t cx, uint32_t cy) {
+    input->cx = cx;
+    input->cy = cy;
+}
+
+void mock_input_advance(obs_source_t *input) {
+    input->frame++;
+}
+
+void mock_input_set_active(obs_source_t *input, bool active) {
+    input->active = active;
+}
+
+obs_source_t *mock_filter_create(const struct obs_source_info *info, obs_source_t *target, obs_source_t *parent,
+                                 obs_data_t *settings) {
+    obs_source_t *filter = bzalloc(sizeof(obs_source_t));
+    filter->info = info;
+    filter->target = target;
+    filter->parent = parent;
+    filter->settings = settings;
+    if (info->get_defaults2) {
+        info->get_defaults2(info->type_data, settings);
+    } else if (info->get_defaults) {
+        info->get_defaults(settings);
+    }
+    filter->data = info->create(settings, filter);
+    return filter;
+}
+
+void *mock_filter_data(obs_source_t *filter) {
+    return filter->data;
+}
+
+void mock_source_destroy(obs_source_t *source) {
+    if (!source) return;
+    if (source->info && source->info->destroy) {
+        source->info->destroy(source->data);
+    }
+    bfree(source);
+}
+
+// as in libobs, updates requested through obs_source_update land on the next tick
+void obs_source_update(obs_source_t *source, obs_data_t *settings) {
+    UNUSED_PARAMETER(settings);
+    os_atomic_store_bool(&source->update_pending, true);
+}
+
+obs_source_t *obs_filter_get_target(const obs_source_t *filter) {
+    return filter->info ? filter->target : NULL;
+}
+
+obs_source_t *obs_filter_get_parent(const obs_source_t *filter) {
+    return filter->info ? filter->parent : NULL;
+}
+
+// as in libobs; the harness's inputs are synchronous, so only frames made by
+// whoever drives a media filter come through here
+void obs_source_release_frame(obs_source_t *source, struct obs_source_frame *frame) {
+    UNUSED_PARAMETER(source);
+    if (frame && os_atomic_dec_long(&frame->refs) == 0) obs_source_frame_destroy(frame);
+}
+
+const char *obs_source_get_id(const obs_source_t *source) {
+    return source->info ? source->info->id : "mock_input";
+}
+
+bool obs_source_enabled(const obs_source_t *source) {
+    UNUSED_PARAMETER(source);
+    return true;
+}
+
+bool obs_source_active(const obs_source_t *source) {
+    return source->active;
+}
+
+void *obs_obj_get_data(void *obj) {
+    return obj ? ((obs_source_t *)obj)->data : NULL;
+}
+
+uint32_t obs_source_get_output_flags(const obs_source_t *source) {
+    return source->info ? source->info->output_flags : OBS_SOURCE_VIDEO;
+}
+
+uint32_t obs_source_get_width(obs_source_t *source) {
+    if (!source->info) return source->cx;
+    return source->info->get_width ? source->info->get_width(source->data) : obs_source_get_width(source->target);
+}
+
+uint32_t obs_source_get_height(obs_source_t *source) {
+    if (!source->info) return source->cy;
+    return source->info->get_height ? source->info->get_height(source->data) : obs_source_get_height(source->target);
+}
+
+enum gs_color_space obs_source_get_color_space(obs_source_t *source, size_t count,
+                                               const enum gs_color_space *preferred_spaces) {
+    if (source->info && source->info->video_get_color_space) {
+        return source->info->video_get_color_space(source->data, count, preferred_spaces);
+    }
+    if (source->info) return obs_source_get_color_space(source->target, count, preferred_spaces);
+    return source->space;
+}
+
+static inline uint16_t unorm_to_half(uint8_t v) {
+    if (v == 0) return 0;
+    int e;
+    const float m = frexpf((float)v / 255.0f, &e);
+    return (uint16_t)(((e - 1 + 15) << 10) | ((uint32_t)((m * 2.0f - 1.0f) * 1024.0f) & 0x3ff));
+}
+
+// draws a gradient with a moving pattern; ticker content only moves in a band
+// along the bottom edge
+static void input_draw(obs_source_t *input) {
+    gs_texture_t *t = current_target();
+    if (!t) return;
+
+    const uint64_t start = tool_now_ns();
+    const uint32_t w = input->cx < t->width ? input->cx : t->width;
+    const uint32_t h = input->cy < t->height ? input->cy : t->height;
+    const uint32_t band = input->content == MOCK_CONTENT_TICKER ? h - h / 10 : 0;
+    const bool half = t->format == GS_RGBA16F;
+
+    for (uint32_t y = 0; y < h; y++) {
+        const uint32_t f = y >= band ? input->frame : 0;
+        uint8_t *row = t->data + (size_t)y * t->linesize;
+        for (uint32_t x = 0; x < w; x++) {
+            const uint8_t px[4] = {
+                (uint8_t)(x * 255 / w + f * 3),
+                (uint8_t)(y * 255 / h),
+                (uint8_t)((((x + f * 4) / 16) ^ (y / 16)) & 1 ? 224 : 32),
+                255,
+            };
+            if (half) {
+                uint16_t *out = (uint16_t *)row + (size_t)x * 4;
+                for (int c = 0; c < 4; c++) out[c] = unorm_to_half(px[c]);
+            } else {
+                memcpy(row + (size_t)x * 4, px, 4);
+            }
+        }
+    }
+    mock_stats.gpu_ns += tool_now_ns() - start;
+}
+
+void obs_source_video_render(obs_source_t *source) {
+    if (source->info) {
+        source->info->video_render(source->data, NULL);
+    } else {
+        input_draw(source);
+    }
+}
+
+void obs_source_default_render(obs_source_t *source) {
+    if (!source->info) input_draw(source);
+}
+
+void obs_source_skip_video_filter(obs_source_t *filter) {
+    mock_stats.skips++;
+    obs_source_video_render(filter->target);
+}
+
+static uint64_t video_frame_time;
+
+uint64_t obs_get_video_frame_time(void) {
+    return video_frame_time;
+}
+
+void mock_render_frame(obs_source_t *input, obs_source_t *const *tops, size_t count) {
+    video_frame_time += 1000000000ULL / 60;
+
+    for (size_t i = 0; i < count; i++) {
+        for (obs_source_t *s = tops[i]; s && s != input; s = s->target) {
+            if (os_atomic_exchange_bool(&s->update_pending, false) && s->info->update) {
+                s->info->update(s->data, s->settings);
+            }
+            if (s->info->video_tick) {
+                s->info->video_tick(s->data, 1.0f / 60.0f);
+            }
+        }
+    }
+
+    static gs_texture_t *output;
+    const uint32_t cx = obs_source_get_width(input), cy = obs_source_get_height(input);
+    const enum gs_color_format format = gs_get_format_from_space(input->space);
+    if (!output || output->width != cx || output->height != cy || output->format != format) {
+        gs_texture_destroy(output);
+        output = gs_texture_create(cx, cy, format, 1, NULL, GS_RENDER_TARGET);
+    }
+
+    targets[target_depth++] = output;
+    for (size_t i = 0; i < count; i++)
+        obs_source_video_render(tops[i]);
+    target_depth--;
+}
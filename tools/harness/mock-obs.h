@@ -0,0 +1,70 @@
+/*
+ntsc-rs-obs
+Copyright (C) 2025 eigenpunk
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along
+with this program. If not, see <https://www.gnu.org/licenses/>
+*/
+
+#pragma once
+
+// Plain-memory stand-in for the parts of libobs and libobs-graphics the plugin
+// calls. The plugin is compiled against the real libobs headers and linked
+// against mock-obs.c instead of libobs, so the code under test is unchanged.
+// Single render thread only; filter_update may be called from anywhere.
+
+#include <obs-module.h>
+
+enum mock_content {
+    // every row changes every frame
+    MOCK_CONTENT_MOTION,
+    // static picture with a scrolling band along the bottom edge
+    MOCK_CONTENT_TICKER,
+};
+
+struct mock_stats {
+    uint64_t readback_bytes;
+    uint64_t upload_bytes;
+    uint64_t draws;
+    uint64_t skips;
+    // time the stand-in spent on work a GPU would do (drawing the input,
+    // staging copies, sprites), which isn't the plugin's cost
+    uint64_t gpu_ns;
+};
+
+extern struct mock_stats mock_stats;
+// messages above this level are dropped
+extern int mock_log_level;
+
+// loads the module and returns the registered info for id, or NULL
+const struct obs_source_info *mock_load_module(const char *id);
+void mock_unload_module(void);
+
+obs_source_t *mock_input_create(uint32_t cx, uint32_t cy, enum gs_color_space space, enum mock_content content);
+void mock_input_resize(obs_source_t *input, uint32_t cx, uint32_t cy);
+// moves the input's content on by one frame
+void mock_input_advance(obs_source_t *input);
+void mock_input_set_active(obs_source_t *input, bool active);
+
+// creates a filter of the given type on top of target, which is either the
+// input itself or the previous filter on it
+obs_source_t *mock_filter_create(const struct obs_source_info *info, obs_source_t *target, obs_source_t *parent,
+                                 obs_data_t *settings);
+void *mock_filter_data(obs_source_t *filter);
+
+// starts a new video tick, runs pending updates and video_tick on every
+// filter below each of tops, then renders each top filter into the output
+// target, as happens when one source is shown in several scenes at once
+void mock_render_frame(obs_source_t *input, obs_source_t *const *tops, size_t count);
+
+void mock_source_destroy(obs_source_t *source);
@@ -0,0 +1,257 @@
+/*
+ntsc-rs-obs
+Copyright (C) 2025 eigenpunk
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along
+with this program. If not, see <https://www.gnu.org/licenses/>
+*/
+
+// Drives the real filter code (create, update, tick, render, destroy) against
+// the plain-memory stand-in in mock-obs.c, so filter_render can be profiled
+// without OBS or a GPU. Frame times include the readback and upload copies;
+// the stand-in's own drawing is reported separately and left out of them.
+
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <util/threading.h>
+
+#include "mock-obs.h"
+#include "plugin-props.h"
+#include "param-builder.h"
+#include "tool-common.h"
+
+#define RESIZE_INTERVAL 15
+
+enum scenario {
+    SCENARIO_STEADY,
+    SCENARIO_RESIZE,
+    SCENARIO_PARAMS,
+    SCENARIO_COUNT,
+};
+
+static const char *scenario_names[SCENARIO_COUNT] = {"steady", "resize", "params"};
+
+struct harness_config {
+    uint32_t cx, cy;
+    long frames;
+    long chain;
+    long copies;
+    bool ticker;
+    bool hdr;
+    bool preview;
+};
+
+struct param_churn {
+    const struct obs_source_info *info;
+    void *data;
+    volatile bool stop;
+    uint64_t updates;
+};
+
+static int compare_u64(const void *a, const void *b) {
+    const uint64_t x = *(const uint64_t *)a, y = *(const uint64_t *)b;
+    return (x > y) - (x < y);
+}
+
+// Stands in for the UI thread: drags a couple of sliders as fast as the
+// filter accepts updates while the render thread keeps going.
+static void *param_churn_thread(void *arg) {
+    struct param_churn *pc = arg;
+    obs_data_t *settings = obs_data_create();
+    pc->info->get_defaults2(pc->info->type_data, settings);
+    obs_data_set_bool(settings, PROP_VHS_SETTINGS, true);
+    obs_data_set_bool(settings, PROP_VHS_EDGE_WAVE_ENABLED, true);
+
+    while (!os_atomic_load_bool(&pc->stop)) {
+        const double t = (double)(pc->updates % 100) / 100.0;
+        obs_data_set_double(settings, PROP_RINGING_FREQUENCY, 0.1 + 0.8 * t);
+        obs_data_set_double(settings, PROP_VHS_EDGE_WAVE_FREQUENCY, 0.01 + 0.1 * t);
+        obs_data_set_int(settings, PROP_RANDOM_SEED, (long long)pc->updates);
+        pc->info->update(pc->data, settings);
+        pc->updates++;
+    }
+
+    obs_data_release(settings);
+    return NULL;
+}
+
+static bool run_scenario(const struct obs_source_info *info, const struct harness_config *cfg, enum scenario sc) {
+    const uint32_t sizes[][2] = {
+        {cfg->cx, cfg->cy},
+        {cfg->cx / 2, cfg->cy / 2},
+        {cfg->cx * 3 / 4, cfg->cy},
+    };
+
+    obs_source_t *input = mock_input_create(cfg->cx, cfg->cy, cfg->hdr ? GS_CS_709_EXTENDED : GS_CS_SRGB,
+                                            cfg->ticker ? MOCK_CONTENT_TICKER : MOCK_CONTENT_MOTION);
+    mock_input_set_active(input, !cfg->preview);
+
+    obs_data_t *settings = obs_data_create();
+    obs_data_set_bool(settings, PROP_INCREMENTAL, cfg->ticker);
+
+    // each copy is a separate stack of filters on the same input, like one
+    // source shown in several scenes that each have their own filter
+    const size_t n_filters = (size_t)(cfg->chain * cfg->copies);
+    obs_source_t **filters = calloc(n_filters, sizeof(*filters));
+    obs_source_t **tops = calloc((size_t)cfg->copies, sizeof(*tops));
+    uint64_t *times = malloc((size_t)cfg->frames * sizeof(*times));
+    if (!filters || !tops || !times) {
+        fprintf(stderr, "out of memory\n");
+        return false;
+    }
+    for (long c = 0; c < cfg->copies; c++) {
+        obs_source_t *below = input;
+        for (long i = 0; i < cfg->chain; i++) {
+            below = filters[c * cfg->chain + i] = mock_filter_create(info, below, input, settings);
+        }
+        tops[c] = below;
+    }
+    obs_source_t *top = tops[0];
+
+    // the properties view is built on the UI thread whenever it's opened
+    obs_properties_t *props = info->get_properties(mock_filter_data(top));
+    obs_properties_destroy(props);
+
+    struct param_churn churn = {.info = info, .data = mock_filter_data(top)};
+    pthread_t churn_thread;
+
+    memset(&mock_stats, 0, sizeof(mock_stats));
+    uint64_t submitted_before, built_before;
+    param_builder_stats(&submitted_before, &built_before);
+    size_t n = 0;
+    for (long f = 0; f < cfg->frames; f++) {
+        // filter_update has a single writer, so wait until the update queued
+        // by filter_create has been applied on the first tick
+        if (sc == SCENARIO_PARAMS && f == 1 && pthread_create(&churn_thread, NULL, param_churn_thread, &churn) != 0) {
+            fprintf(stderr, "failed to start update thread\n");
+            return false;
+        }
+        if (sc == SCENARIO_RESIZE && f % RESIZE_INTERVAL == 0) {
+            const size_t i = (size_t)(f / RESIZE_INTERVAL) % OBS_COUNTOF(sizes);
+            mock_input_resize(input, sizes[i][0], sizes[i][1]);
+        }
+        mock_input_advance(input);
+
+        const uint64_t gpu_before = mock_stats.gpu_ns;
+        const uint64_t start = tool_now_ns();
+        mock_render_frame(input, tops, (size_t)cfg->copies);
+        const uint64_t elapsed = tool_now_ns() - start;
+        times[n++] = elapsed - (mock_stats.gpu_ns - gpu_before);
+    }
+
+    if (sc == SCENARIO_PARAMS && cfg->frames > 1) {
+        os_atomic_store_bool(&churn.stop, true);
+        pthread_join(churn_thread, NULL);
+    }
+
+    uint64_t total = 0;
+    for (size_t i = 0; i < n; i++)
+        total += times[i];
+    qsort(times, n, sizeof(*times), compare_u64);
+
+    const double mean_ms = (double)total / (double)n / 1e6;
+    const double mb = 1024.0 * 1024.0 * (double)n;
+    printf("%s: %zu frames, %ux%u%s%s%s, %ld filter(s) x %ld\n", scenario_names[sc], n, cfg->cx, cfg->cy,
+           cfg->hdr ? ", hdr" : "", cfg->ticker ? ", ticker + incremental" : "", cfg->preview ? ", preview" : "",
+           cfg->chain, cfg->copies);
+    printf("  mean:     %.3f ms\n", mean_ms);
+    printf("  p50:      %.3f ms\n", (double)times[n / 2] / 1e6);
+    printf("  p99:      %.3f ms\n", (double)times[(n * 99) / 100] / 1e6);
+    printf("  max:      %.3f ms\n", (double)times[n - 1] / 1e6);
+    printf("  skipped:  %" PRIu64 "\n", mock_stats.skips);
+    printf("  readback: %.2f MiB/frame\n", (double)mock_stats.readback_bytes / mb);
+    printf("  upload:   %.2f MiB/frame\n", (double)mock_stats.upload_bytes / mb);
+    printf("  mock gpu: %.3f ms/frame (not included above)\n", (double)mock_stats.gpu_ns / (double)n / 1e6);
+    if (sc == SCENARIO_PARAMS) {
+        uint64_t submitted, built;
+        param_builder_stats(&submitted, &built);
+        printf("  updates:  %" PRIu64 " (%.1f per frame)\n", churn.updates, (double)churn.updates / (double)n);
+        printf("  builds:   %" PRIu64 " of %" PRIu64 " submitted sets\n", built - built_before,
+               submitted - submitted_before);
+    }
+
+    for (size_t i = n_filters; i > 0; i--)
+        mock_source_destroy(filters[i - 1]);
+    mock_source_destroy(input);
+    obs_data_release(settings);
+    free(filters);
+    free(tops);
+    free(times);
+    return true;
+}
+
+static void usage(const char *argv0) {
+    fprintf(stderr,
+            "usage: %s [-s steady|resize|params|all] [-n frames] [-r WxH] [-c chain_length] [-d copies] [-t] [-e] [-p] [-v]\n",
+            argv0);
+}
+
+int main(int argc, char **argv) {
+    struct harness_config cfg = {.cx = 1280, .cy = 720, .frames = 300, .chain = 1, .copies = 1};
+    int only = -1;
+
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "-s") && i + 1 < argc) {
+            const char *name = argv[++i];
+            only = SCENARIO_COUNT;
+            for (int s = 0; s < SCENARIO_COUNT; s++) {
+                if (!strcmp(name, scenario_names[s])) only = s;
+            }
+            if (!strcmp(name, "all")) only = -1;
+            if (only == SCENARIO_COUNT) {
+                usage(argv[0]);
+                return 2;
+            }
+        } else if (!strcmp(argv[i], "-n") && i + 1 < argc) {
+            cfg.frames = strtol(argv[++i], NULL, 10);
+        } else if (!strcmp(argv[i], "-r") && i + 1 < argc) {
+            if (sscanf(argv[++i], "%ux%u", &cfg.cx, &cfg.cy) != 2) cfg.cx = 0;
+        } else if (!strcmp(argv[i], "-c") && i + 1 < argc) {
+            cfg.chain = strtol(argv[++i], NULL, 10);
+        } else if (!strcmp(argv[i], "-d") && i + 1 < argc) {
+            cfg.copies = strtol(argv[++i], NULL, 10);
+        } else if (!strcmp(argv[i], "-t")) {
+            cfg.ticker = true;
+        } else if (!strcmp(argv[i], "-e")) {
+            cfg.hdr = true;
+        } else if (!strcmp(argv[i], "-p")) {
+            cfg.preview = true;
+        } else if (!strcmp(argv[i], "-v")) {
+            mock_log_level = LOG_DEBUG;
+        } else {
+            usage(argv[0]);
+            return 2;
+        }
+    }
+    if (cfg.frames < 1 || cfg.chain < 1 || cfg.copies < 1 || cfg.cx < 2 || cfg.cy < 2) {
+        usage(argv[0]);
+        return 2;
+    }
+
+    const struct obs_source_info *info = mock_load_module("ntsc_rs_filter");
+    if (!info) {
+        fprintf(stderr, "module did not register the filter\n");
+        return 1;
+    }
+
+    bool ok = true;
+    for (int s = 0; s < SCENARIO_COUNT && ok; s++) {
+        if (only < 0 || only == s) ok = run_scenario(info, &cfg, (enum scenario)s);
+    }
+
+    mock_unload_module();
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,826 @@
+/*
+ntsc-rs-obs
+Copyright (C) 2025 eigenpunk
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along
+with this program. If not, see <https://www.gnu.org/licenses/>
+*/
+
+// Golden-frame check for the effect. `generate` renders a fixed matrix of
+// images x presets x (seed, frame number) x pixel formats x quality modes and
+// stores the raw outputs; `verify` renders the same matrix again and compares
+// each frame against its golden, exactly or against the mode's PSNR floor.
+// Every case is also rendered twice to catch run-to-run nondeterminism, and
+// ntscrs_plan_params is checked to leave the output unchanged.
+// Two more sets of cases follow the plugin's own paths: fused filters, which
+// apply a chain of presets to one buffer, each with its own seed and frame
+// number, and incremental processing (dirty-rows.c), whose output after a few
+// rows change has to match a full pass over the new frame bit for bit.
+// Goldens depend on the ntsc-rs revision, so generate them from a known-good
+// build before changing anything that could affect the output. With -R the
+// revision is stamped into the directory by `generate`, and `verify` refuses
+// goldens stamped with a different one; the CTest `golden` test passes the
+// revision Cargo.lock pins. `verify` on a directory without goldens exits
+// with EXIT_SKIP, which CTest reports as skipped.
+//
+// `bench` times the same presets, formats and quality modes on the synthetic
+// images at a realistic size. It's the workload profile-guided builds are
+// trained on, and what to compare between build modes.
+
+#include <inttypes.h>
+#include <math.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <util/bmem.h>
+
+#include "tool-common.h"
+#include "dirty-rows.h"
+
+#define GOLDEN_WIDTH 192
+#define GOLDEN_HEIGHT 144
+#define MAX_IMAGES 32
+
+#define BENCH_WIDTH 1280
+#define BENCH_HEIGHT 720
+#define BENCH_LOOPS 5
+
+#define COUNTOF(a) (sizeof(a) / sizeof((a)[0]))
+
+// in the golden directory, next to the frames
+#define REVISION_FILE "REVISION"
+
+// verify found no goldens; the golden test's SKIP_RETURN_CODE
+#define EXIT_SKIP 77
+
+// as in plugin-main.c
+#define MAX_DIRTY_BANDS 16
+
+struct golden_image {
+    char name[64];
+    uint32_t width, height;
+    uint8_t *rgbx8;
+};
+
+struct golden_preset {
+    const char *name;
+    void (*apply)(NtscRsEffectParams *p);
+};
+
+struct golden_mode {
+    const char *name;
+    bool draft;
+    // INFINITY means the output has to match bit for bit
+    double min_psnr;
+};
+
+struct golden_format {
+    const char *name;
+    NtscRsPixelFormat pix_fmt;
+    uint32_t bytes_per_pixel;
+};
+
+struct golden_step {
+    int32_t seed;
+    size_t frame;
+};
+
+static void preset_default(NtscRsEffectParams *p) {
+    (void)p;
+}
+
+static void preset_clean(NtscRsEffectParams *p) {
+    p->enable_head_switching = false;
+    p->enable_tracking_noise = false;
+    p->enable_composite_noise = false;
+    p->enable_luma_noise = false;
+    p->enable_chroma_noise = false;
+    p->enable_vhs = false;
+    p->snow_intensity = 0.0f;
+    p->chroma_phase_noise_intensity = 0.0f;
+}
+
+static void preset_vhs(NtscRsEffectParams *p) {
+    p->enable_vhs = true;
+    p->enable_head_switching = true;
+    p->enable_tracking_noise = true;
+    p->vhs_settings.enable_edge_wave = true;
+    p->vhs_settings.enable_sharpen = true;
+}
+
+static void preset_interleaved(NtscRsEffectParams *p) {
+    p->use_field = UseFieldInterleavedUpper;
+}
+
+// Stages that are on but set up to do nothing, for checking the stage plan;
+// not part of the golden matrix.
+static void idle_stages(NtscRsEffectParams *p) {
+    p->enable_head_switching = true;
+    p->head_switching.height = 0;
+    p->enable_tracking_noise = true;
+    p->tracking_noise.height = 0;
+    p->enable_composite_noise = true;
+    p->composite_noise.intensity = 0.0f;
+    p->enable_luma_noise = true;
+    p->luma_noise.intensity = 0.0f;
+    p->enable_chroma_noise = true;
+    p->chroma_noise.intensity = 0.0f;
+    p->enable_ringing = true;
+    p->ringing.intensity = 0.0f;
+    p->enable_vhs = true;
+    p->vhs_settings.tape_speed = TapeSpeedNONE;
+    p->vhs_settings.chroma_loss = 0.0f;
+    p->vhs_settings.enable_sharpen = true;
+    p->vhs_settings.sharpen_intensity = 0.0f;
+    p->vhs_settings.enable_edge_wave = true;
+    p->vhs_settings.edge_wave_intensity = 0.0f;
+}
+
+static const struct golden_preset presets[] = {
+    {"default", preset_default},
+    {"clean", preset_clean},
+    {"vhs", preset_vhs},
+    {"interleaved", preset_interleaved},
+};
+
+// draft is lossy by design, so small rounding changes in its scaler are allowed
+static const struct golden_mode modes[] = {
+    {"full", false, INFINITY},
+    {"draft", true, 45.0},
+};
+
+static const struct golden_format formats[] = {
+    {"rgbx8", Rgbx8, 4},
+    {"rgbx16", Rgbx16, 8},
+};
+
+static const struct golden_step steps[] = {
+    {0, 0},
+    {1234, 1},
+    {1234, 60},
+};
+
+// Fused filters, bottom first. Each one's seed and frame number are offset by
+// its position, as separate filters' would be.
+static const struct golden_preset *const chains[][2] = {
+    {&presets[2], &presets[3]},
+    {&presets[1], &presets[0]},
+};
+
+// settings incremental processing takes, with both kinds of fixed field
+static void preset_static_upper(NtscRsEffectParams *p) {
+    preset_clean(p);
+    p->use_field = UseFieldUpper;
+    p->scale.scale_with_video_size = false;
+}
+
+static void preset_static_both(NtscRsEffectParams *p) {
+    preset_static_upper(p);
+    p->use_field = UseFieldBoth;
+}
+
+static const struct golden_preset incremental_presets[] = {
+    {"static-upper", preset_static_upper},
+    {"static-both", preset_static_both},
+};
+
+// dirty-rows.c allocates through libobs, which the tools don't link
+void *bmalloc(size_t size) {
+    return malloc(size);
+}
+
+void bfree(void *ptr) {
+    free(ptr);
+}
+
+/*
+ * IMAGES
+ */
+
+static struct golden_image *image_new(struct golden_image *images, size_t *count, const char *name, uint32_t w,
+                                      uint32_t h) {
+    if (*count == MAX_IMAGES) return NULL;
+    struct golden_image *img = &images[(*count)++];
+    snprintf(img->name, sizeof(img->name), "%s", name);
+    img->width = w;
+    img->height = h;
+    img->rgbx8 = calloc((size_t)w * h, 4);
+    return img->rgbx8 ? img : NULL;
+}
+
+static inline void put(struct golden_image *img, uint32_t x, uint32_t y, uint8_t r, uint8_t g, uint8_t b) {
+    uint8_t *px = img->rgbx8 + ((size_t)y * img->width + x) * 4;
+    px[0] = r;
+    px[1] = g;
+    px[2] = b;
+    px[3] = 255;
+}
+
+static bool make_synthetic_images(struct golden_image *images, size_t *count, uint32_t w, uint32_t h) {
+    struct golden_image *img;
+
+    if (!(img = image_new(images, count, "gradient", w, h))) return false;
+    for (uint32_t y = 0; y < h; y++)
+        for (uint32_t x = 0; x < w; x++)
+            put(img, x, y, (uint8_t)(x * 255 / (w - 1)), (uint8_t)(y * 255 / (h - 1)),
+                (uint8_t)((x + y) * 255 / (w + h - 2)));
+
+    // 75% color bars
+    static const uint8_t bars[7][3] = {
+        {191, 191, 191}, {191, 191, 0}, {0, 191, 191}, {0, 191, 0}, {191, 0, 191}, {191, 0, 0}, {0, 0, 191},
+    };
+    if (!(img = image_new(images, count, "bars", w, h))) return false;
+    for (uint32_t y = 0; y < h; y++)
+        for (uint32_t x = 0; x < w; x++) {
+            const uint8_t *c = bars[x * 7 / w];
+            put(img, x, y, c[0], c[1], c[2]);
+        }
+
+    if (!(img = image_new(images, count, "zoneplate", w, h))) return false;
+    for (uint32_t y = 0; y < h; y++)
+        for (uint32_t x = 0; x < w; x++) {
+            const double dx = (double)x - w / 2.0, dy = (double)y - h / 2.0;
+            const uint8_t v = (uint8_t)lround(127.5 + 127.5 * cos((dx * dx + dy * dy) * 0.02));
+            put(img, x, y, v, v, v);
+        }
+
+    // fixed LCG so the image is the same on every platform
+    if (!(img = image_new(images, count, "noise", w, h))) return false;
+    uint32_t state = 0x6e747363u;
+    for (uint32_t y = 0; y < h; y++)
+        for (uint32_t x = 0; x < w; x++) {
+            uint8_t c[3];
+            for (int i = 0; i < 3; i++) {
+                state = state * 1664525u + 1013904223u;
+                c[i] = (uint8_t)(state >> 24);
+            }
+            put(img, x, y, c[0], c[1], c[2]);
+        }
+
+    // hard edges and single-pixel lines, where ringing and chroma bleed show
+    if (!(img = image_new(images, count, "edges", w, h))) return false;
+    for (uint32_t y = 0; y < h; y++)
+        for (uint32_t x = 0; x < w; x++) {
+            uint8_t v = ((x / 8) ^ (y / 8)) & 1 ? 235 : 16;
+            if (x % 24 == 0 || y % 18 == 0) v = 255 - v;
+            put(img, x, y, v, x % 48 < 24 ? v : 128, v);
+        }
+
+    return true;
+}
+
+static bool ppm_skip_space(FILE *f) {
+    int c;
+    while ((c = fgetc(f)) != EOF) {
+        if (c == '#') {
+            while ((c = fgetc(f)) != EOF && c != '\n') {}
+        } else if (c != ' ' && c != '\t' && c != '\r' && c != '\n') {
+            ungetc(c, f);
+            return true;
+        }
+    }
+    return false;
+}
+
+// binary 8-bit PPM (P6) only; the file name without directory and extension
+// becomes the image name
+static bool load_ppm(struct golden_image *images, size_t *count, const char *path) {
+    FILE *f = fopen(path, "rb");
+    if (!f) return false;
+
+    unsigned w = 0, h = 0, maxval = 0;
+    char magic[3] = {0};
+    bool ok = fread(magic, 1, 2, f) == 2 && strcmp(magic, "P6") == 0 && ppm_skip_space(f) && fscanf(f, "%u", &w) == 1 &&
+              ppm_skip_space(f) && fscanf(f, "%u", &h) == 1 && ppm_skip_space(f) &&
+              fscanf(f, "%u", &maxval) == 1 && fgetc(f) != EOF && maxval == 255 && w >= 2 && h >= 2 &&
+              w <= 8192 && h <= 8192;
+
+    const char *base = path;
+    for (const char *p = path; *p; p++) {
+        if (*p == '/' || *p == '\\') base = p + 1;
+    }
+    char name[64];
+    snprintf(name, sizeof(name), "%s", base);
+    char *dot = strrchr(name, '.');
+    if (dot) *dot = '\0';
+
+    struct golden_image *img = ok ? image_new(images, count, name, w, h) : NULL;
+    for (uint32_t i = 0; img && i < w * h; i++) {
+        uint8_t rgb[3];
+        if (fread(rgb, 1, 3, f) != 3) {
+            img = NULL;
+            break;
+        }
+        put(img, i % w, i / w, rgb[0], rgb[1], rgb[2]);
+    }
+    fclose(f);
+    return img != NULL;
+}
+
+/*
+ * CASES
+ */
+
+// img in fmt, as the effect gets it
+static void load(const struct golden_image *img, const struct golden_format *fmt, uint8_t *out) {
+    const size_t pixels = (size_t)img->width * img->height;
+    if (fmt->bytes_per_pixel == 8) {
+        uint16_t *wide = (uint16_t *)out;
+        for (size_t i = 0; i < pixels * 4; i++)
+            wide[i] = (uint16_t)(img->rgbx8[i] * 257);
+    } else {
+        memcpy(out, img->rgbx8, pixels * 4);
+    }
+}
+
+static void apply(const NtscRsEffectParams *params, const struct golden_format *fmt, const struct golden_mode *mode,
+                  uint32_t width, uint32_t height, size_t frame, uint8_t *buf) {
+    if (mode->draft) {
+        ntscrs_apply_effect_to_buffer_draft(*params, width, height, buf, fmt->pix_fmt, frame);
+    } else {
+        ntscrs_apply_effect_to_buffer(*params, width, height, buf, fmt->pix_fmt, frame);
+    }
+}
+
+static void render(const struct golden_image *img, const NtscRsEffectParams *params, const struct golden_format *fmt,
+                   const struct golden_mode *mode, size_t frame, uint8_t *out) {
+    load(img, fmt, out);
+    apply(params, fmt, mode, img->width, img->height, frame, out);
+}
+
+// Renders the chain in one buffer, bottom first.
+static void render_chain(const struct golden_image *img, const struct golden_preset *const *chain, size_t length,
+                         int32_t seed, const struct golden_format *fmt, const struct golden_mode *mode, size_t frame,
+                         uint8_t *out) {
+    load(img, fmt, out);
+    for (size_t i = 0; i < length; i++) {
+        NtscRsEffectParams params;
+        ntscrs_default_effect_params(&params);
+        chain[i]->apply(&params);
+        params.random_seed = seed + (int32_t)i;
+        apply(&params, fmt, mode, img->width, img->height, frame + i, out);
+    }
+}
+
+// A few rows of the frame changed: a short stripe a third of the way down,
+// and the last row, where bands are cut short by the edge of the frame.
+static void change_rows(uint8_t *buf, size_t linesize, uint32_t height) {
+    for (uint32_t y = height / 3; y < height / 3 + 3; y++) {
+        for (size_t i = 0; i < linesize; i++)
+            buf[y * linesize + i] ^= 0x5a;
+    }
+    for (size_t i = 0; i < linesize; i++)
+        buf[(height - 1) * linesize + i] = (uint8_t)~buf[(height - 1) * linesize + i];
+}
+
+// Runs the frame through the incremental path: a full pass over img, then
+// only the bands around the rows change_rows touched. out gets the complete
+// output and full a full pass over the changed frame. Returns false if the
+// rows weren't processed as bands.
+static bool render_incremental(const struct golden_image *img, const NtscRsEffectParams *params,
+                               const struct golden_format *fmt, const struct golden_mode *mode, size_t frame,
+                               uint8_t *out, uint8_t *full) {
+    const size_t linesize = (size_t)img->width * fmt->bytes_per_pixel;
+    NtscRsEffect *effect = ntscrs_effect_create(*params);
+    struct dirty_rows dr = {0};
+    if (!effect || !dirty_rows_resize(&dr, linesize, img->height)) {
+        ntscrs_effect_free(effect);
+        return false;
+    }
+
+    load(img, fmt, out);
+    dirty_rows_apply_full(&dr, out, effect, mode->draft, img->width, fmt->pix_fmt, frame);
+
+    load(img, fmt, full);
+    change_rows(full, linesize, img->height);
+    struct dirty_band bands[MAX_DIRTY_BANDS];
+    const size_t n = dirty_rows_find(&dr, full, dirty_rows_halo(params), bands, MAX_DIRTY_BANDS);
+    const bool banded = n != DIRTY_ROWS_ALL && n > 0;
+    if (banded) {
+        const uint8_t *merged = dirty_rows_apply_bands(&dr, full, bands, n, effect, mode->draft, img->width,
+                                                       fmt->pix_fmt);
+        memcpy(out, merged, linesize * img->height);
+    }
+
+    apply(params, fmt, mode, img->width, img->height, frame, full);
+    dirty_rows_free(&dr);
+    ntscrs_effect_free(effect);
+    return banded;
+}
+
+static bool read_file(const char *path, uint8_t *buf, size_t size) {
+    FILE *f = fopen(path, "rb");
+    if (!f) return false;
+    const bool ok = fread(buf, 1, size, f) == size && fgetc(f) == EOF;
+    fclose(f);
+    return ok;
+}
+
+static bool write_file(const char *path, const uint8_t *buf, size_t size) {
+    FILE *f = fopen(path, "wb");
+    if (!f) return false;
+    const bool ok = fwrite(buf, 1, size, f) == size;
+    return fclose(f) == 0 && ok;
+}
+
+// Writes or checks the directory's revision stamp. verify without -R only
+// needs the stamp to exist, i.e. goldens to have been generated at all.
+// Returns the exit status to stop with, 0 to go on.
+static int check_revision(const char *dir, const char *revision, bool generate) {
+    char path[1024];
+    snprintf(path, sizeof(path), "%s/" REVISION_FILE, dir);
+
+    if (generate) {
+        const char *stamp = revision ? revision : "unknown";
+        if (!write_file(path, (const uint8_t *)stamp, strlen(stamp))) {
+            fprintf(stderr, "%s: write failed\n", path);
+            return 1;
+        }
+        return 0;
+    }
+
+    char stamp[128] = {0};
+    FILE *f = fopen(path, "rb");
+    if (!f) {
+        fprintf(stderr, "%s: no goldens here, skipping; generate them from a known-good build first\n", dir);
+        return EXIT_SKIP;
+    }
+    const size_t len = fread(stamp, 1, sizeof(stamp) - 1, f);
+    fclose(f);
+    stamp[len] = 0;
+    if (revision && strcmp(stamp, revision) != 0) {
+        fprintf(stderr, "%s: goldens are for ntsc-rs %s, this build uses %s; generate them again\n", dir, stamp,
+                revision);
+        return 1;
+    }
+    return 0;
+}
+
+// how far out drifted from expected, for the failure message
+static void describe_drift(const uint8_t *out, const uint8_t *expected, size_t size, const struct golden_format *fmt,
+                           uint32_t width) {
+    const bool wide = fmt->bytes_per_pixel == 8;
+    const size_t samples = wide ? size / 2 : size;
+    const size_t row_samples = (size_t)width * 4;
+    size_t differing = 0, first_row = SIZE_MAX;
+    unsigned max_diff = 0;
+    for (size_t i = 0; i < samples; i++) {
+        const int a = wide ? ((const uint16_t *)out)[i] : out[i];
+        const int b = wide ? ((const uint16_t *)expected)[i] : expected[i];
+        if (a == b) continue;
+        const unsigned d = (unsigned)abs(a - b);
+        if (d > max_diff) max_diff = d;
+        if (first_row == SIZE_MAX) first_row = i / row_samples;
+        differing++;
+    }
+    printf("    psnr %.2f dB, max diff %u, %zu of %zu samples differ (%.3f%%), first at row %zu\n",
+           tool_psnr(out, expected, size, fmt->pix_fmt), max_diff, differing, samples,
+           100.0 * (double)differing / (double)samples, first_row);
+}
+
+// A case's name, which is also its golden's file name. Returns false if it
+// doesn't fit.
+static bool case_name(char *name, size_t size, const char *format, ...) {
+    va_list args;
+    va_start(args, format);
+    const int len = vsnprintf(name, size, format, args);
+    va_end(args);
+    if (len < 0 || (size_t)len >= size) {
+        fprintf(stderr, "%s: name too long\n", name);
+        return false;
+    }
+    return true;
+}
+
+struct golden_run {
+    const char *dir;
+    bool generate;
+    double min_psnr_override;
+    uint8_t *expected;
+    size_t cases, failures;
+};
+
+// Writes out as the golden called name, or checks it against that golden.
+// again is a second render of the same case, which has to be identical.
+// Returns false if the run can't go on.
+static bool golden_case(struct golden_run *run, const char *name, const uint8_t *out, const uint8_t *again,
+                        size_t size, const struct golden_format *fmt, const struct golden_mode *mode, uint32_t width) {
+    char path[1024];
+    const int len = snprintf(path, sizeof(path), "%s/%s.raw", run->dir, name);
+    if (len < 0 || (size_t)len >= sizeof(path)) {
+        fprintf(stderr, "%s: path too long\n", run->dir);
+        return false;
+    }
+    run->cases++;
+
+    if (memcmp(out, again, size) != 0) {
+        printf("FAIL %s: two runs with identical input differ\n", name);
+        describe_drift(again, out, size, fmt, width);
+        run->failures++;
+        return true;
+    }
+
+    if (run->generate) {
+        if (!write_file(path, out, size)) {
+            fprintf(stderr, "%s: write failed\n", path);
+            return false;
+        }
+        return true;
+    }
+
+    if (!read_file(path, run->expected, size)) {
+        printf("FAIL %s: golden missing or wrong size\n", name);
+        run->failures++;
+        return true;
+    }
+    const double floor = isnan(run->min_psnr_override) ? mode->min_psnr : run->min_psnr_override;
+    const bool exact = isinf(floor);
+    const bool pass = exact ? memcmp(out, run->expected, size) == 0
+                            : tool_psnr(out, run->expected, size, fmt->pix_fmt) >= floor;
+    if (!pass) {
+        printf("FAIL %s: %s\n", name, exact ? "not bit-exact" : "below PSNR floor");
+        describe_drift(out, run->expected, size, fmt, width);
+        run->failures++;
+    }
+    return true;
+}
+
+// Renders every image with idle stages as they are and as planned, at full
+// quality, and reports any difference. Returns the number of failures.
+static size_t check_plan(const struct golden_image *images, size_t image_count, uint8_t *out, uint8_t *planned_out,
+                         size_t *cases) {
+    size_t failures = 0;
+    for (size_t ii = 0; ii < image_count; ii++) {
+        const struct golden_image *img = &images[ii];
+        for (size_t si = 0; si < COUNTOF(steps); si++) {
+            NtscRsEffectParams params, planned;
+            ntscrs_default_effect_params(&params);
+            idle_stages(&params);
+            params.random_seed = steps[si].seed;
+            planned = params;
+            if (ntscrs_plan_params(&planned) == 0) {
+                printf("FAIL stage plan: idle stages were not turned off\n");
+                return failures + 1;
+            }
+
+            for (size_t fi = 0; fi < COUNTOF(formats); fi++) {
+                const struct golden_format *fmt = &formats[fi];
+                const size_t size = (size_t)img->width * img->height * fmt->bytes_per_pixel;
+                (*cases)++;
+
+                render(img, &params, fmt, &modes[0], steps[si].frame, out);
+                render(img, &planned, fmt, &modes[0], steps[si].frame, planned_out);
+                if (memcmp(out, planned_out, size) != 0) {
+                    printf("FAIL %s-s%" PRId32 "-f%zu-%s: stage plan changes output\n", img->name, steps[si].seed,
+                           steps[si].frame, fmt->name);
+                    describe_drift(planned_out, out, size, fmt, img->width);
+                    failures++;
+                }
+            }
+        }
+    }
+    return failures;
+}
+
+/*
+ * BENCHMARK
+ */
+
+static int compare_u64(const void *a, const void *b) {
+    const uint64_t x = *(const uint64_t *)a, y = *(const uint64_t *)b;
+    return (x > y) - (x < y);
+}
+
+// Prints the median frame time of every preset, format and mode over all
+// images and loops, and their sum.
+static int bench(uint32_t w, uint32_t h, size_t loops) {
+    struct golden_image images[MAX_IMAGES];
+    size_t image_count = 0;
+    uint8_t *out = malloc((size_t)w * h * 8);
+    const size_t samples = loops * MAX_IMAGES;
+    uint64_t *times = malloc(samples * sizeof(*times));
+    if (!out || !times || !make_synthetic_images(images, &image_count, w, h)) {
+        fprintf(stderr, "out of memory\n");
+        return 1;
+    }
+
+    printf("%ux%u, %zu images x %zu loops per line\n", w, h, image_count, loops);
+    double total_ms = 0.0;
+    for (size_t pi = 0; pi < COUNTOF(presets); pi++) {
+        NtscRsEffectParams params;
+        ntscrs_default_effect_params(&params);
+        presets[pi].apply(&params);
+
+        for (size_t fi = 0; fi < COUNTOF(formats); fi++) {
+            const struct golden_format *fmt = &formats[fi];
+            for (size_t mi = 0; mi < COUNTOF(modes); mi++) {
+                const struct golden_mode *mode = &modes[mi];
+                if (mode->draft && fmt->bytes_per_pixel != 4) continue;
+
+                // one untimed frame so pool startup isn't counted
+                render(&images[0], &params, fmt, mode, 0, out);
+
+                size_t n = 0;
+                for (size_t loop = 0; loop < loops; loop++) {
+                    for (size_t ii = 0; ii < image_count; ii++) {
+                        const uint64_t start = tool_now_ns();
+                        render(&images[ii], &params, fmt, mode, loop, out);
+                        times[n++] = tool_now_ns() - start;
+                    }
+                }
+                qsort(times, n, sizeof(*times), compare_u64);
+
+                const double ms = (double)times[n / 2] / 1e6;
+                total_ms += ms;
+                printf("%-12s %-7s %-6s %8.3f ms\n", presets[pi].name, fmt->name, mode->name, ms);
+            }
+        }
+    }
+    printf("total        %23.3f ms\n", total_ms);
+
+    for (size_t i = 0; i < image_count; i++)
+        free(images[i].rgbx8);
+    free(times);
+    free(out);
+    return 0;
+}
+
+static void usage(const char *argv0) {
+    fprintf(stderr,
+            "usage: %s generate|verify <golden_dir> [-t min_psnr_db] [-i image.ppm]... [-R revision]\n"
+            "       %s bench [-r WxH] [-n loops]\n",
+            argv0, argv0);
+}
+
+int main(int argc, char **argv) {
+    if (argc >= 2 && strcmp(argv[1], "bench") == 0) {
+        uint32_t w = BENCH_WIDTH, h = BENCH_HEIGHT;
+        size_t loops = BENCH_LOOPS;
+        for (int i = 2; i < argc; i++) {
+            if (!strcmp(argv[i], "-r") && i + 1 < argc) {
+                if (sscanf(argv[++i], "%ux%u", &w, &h) != 2) w = 0;
+            } else if (!strcmp(argv[i], "-n") && i + 1 < argc) {
+                loops = strtoul(argv[++i], NULL, 10);
+            } else {
+                w = 0;
+            }
+        }
+        if (w < 2 || h < 2 || w > 8192 || h > 8192 || loops == 0) {
+            usage(argv[0]);
+            return 2;
+        }
+        return bench(w, h, loops);
+    }
+
+    if (argc < 3 || (strcmp(argv[1], "generate") != 0 && strcmp(argv[1], "verify") != 0)) {
+        usage(argv[0]);
+        return 2;
+    }
+    const bool generate = strcmp(argv[1], "generate") == 0;
+    const char *dir = argv[2];
+
+    struct golden_image images[MAX_IMAGES];
+    size_t image_count = 0;
+    if (!make_synthetic_images(images, &image_count, GOLDEN_WIDTH, GOLDEN_HEIGHT)) {
+        fprintf(stderr, "out of memory\n");
+        return 1;
+    }
+
+    double min_psnr_override = NAN;
+    const char *revision = NULL;
+    for (int i = 3; i < argc; i++) {
+        if (!strcmp(argv[i], "-R") && i + 1 < argc) {
+            revision = argv[++i];
+        } else if (!strcmp(argv[i], "-t") && i + 1 < argc) {
+            min_psnr_override = strtod(argv[++i], NULL);
+        } else if (!strcmp(argv[i], "-i") && i + 1 < argc) {
+            if (!load_ppm(images, &image_count, argv[++i])) {
+                fprintf(stderr, "%s: not a readable 8-bit binary PPM\n", argv[i]);
+                return 1;
+            }
+        } else {
+            usage(argv[0]);
+            return 2;
+        }
+    }
+
+    const int revision_status = check_revision(dir, revision, generate);
+    if (revision_status) return revision_status;
+
+    size_t max_size = 0;
+    for (size_t i = 0; i < image_count; i++) {
+        const size_t size = (size_t)images[i].width * images[i].height * 8;
+        if (size > max_size) max_size = size;
+    }
+    uint8_t *out = malloc(max_size), *again = malloc(max_size), *expected = malloc(max_size);
+    if (!out || !again || !expected) {
+        fprintf(stderr, "out of memory\n");
+        return 1;
+    }
+
+    struct golden_run run = {
+        .dir = dir, .generate = generate, .min_psnr_override = min_psnr_override, .expected = expected};
+    for (size_t ii = 0; ii < image_count; ii++) {
+        const struct golden_image *img = &images[ii];
+        for (size_t si = 0; si < COUNTOF(steps); si++) {
+            const struct golden_step *step = &steps[si];
+            for (size_t fi = 0; fi < COUNTOF(formats); fi++) {
+                const struct golden_format *fmt = &formats[fi];
+                const size_t size = (size_t)img->width * img->height * fmt->bytes_per_pixel;
+
+                for (size_t mi = 0; mi < COUNTOF(modes); mi++) {
+                    const struct golden_mode *mode = &modes[mi];
+                    // draft only differs from full quality for 8-bit frames
+                    if (mode->draft && fmt->bytes_per_pixel != 4) continue;
+
+                    char name[256];
+                    for (size_t pi = 0; pi < COUNTOF(presets); pi++) {
+                        NtscRsEffectParams params;
+                        ntscrs_default_effect_params(&params);
+                        presets[pi].apply(&params);
+                        params.random_seed = step->seed;
+
+                        if (!case_name(name, sizeof(name), "%s-%s-s%" PRId32 "-f%zu-%s-%s", img->name,
+                                       presets[pi].name, step->seed, step->frame, fmt->name, mode->name)) {
+                            return 1;
+                        }
+                        render(img, &params, fmt, mode, step->frame, out);
+                        render(img, &params, fmt, mode, step->frame, again);
+                        if (!golden_case(&run, name, out, again, size, fmt, mode, img->width)) return 1;
+                    }
+
+                    for (size_t ci = 0; ci < COUNTOF(chains); ci++) {
+                        const struct golden_preset *const *chain = chains[ci];
+                        if (!case_name(name, sizeof(name), "%s-fused-%s+%s-s%" PRId32 "-f%zu-%s-%s", img->name,
+                                       chain[0]->name, chain[1]->name, step->seed, step->frame, fmt->name,
+                                       mode->name)) {
+                            return 1;
+                        }
+                        render_chain(img, chain, COUNTOF(chains[ci]), step->seed, fmt, mode, step->frame, out);
+                        render_chain(img, chain, COUNTOF(chains[ci]), step->seed, fmt, mode, step->frame, again);
+                        if (!golden_case(&run, name, out, again, size, fmt, mode, img->width)) return 1;
+                    }
+
+                    for (size_t pi = 0; pi < COUNTOF(incremental_presets); pi++) {
+                        NtscRsEffectParams params;
+                        ntscrs_default_effect_params(&params);
+                        incremental_presets[pi].apply(&params);
+                        params.random_seed = step->seed;
+
+                        if (!case_name(name, sizeof(name), "%s-incremental-%s-s%" PRId32 "-f%zu-%s-%s",
+                                       img->name, incremental_presets[pi].name, step->seed, step->frame, fmt->name,
+                                       mode->name)) {
+                            return 1;
+                        }
+                        if (!dirty_rows_eligible(&params) ||
+                            !render_incremental(img, &params, fmt, mode, step->frame, out, again)) {
+                            printf("FAIL %s: changed rows weren't processed incrementally\n", name);
+                            run.cases++;
+                            run.failures++;
+                            continue;
+                        }
+                        // reused rows have to match what a full pass makes of them exactly, in either mode
+                        if (memcmp(out, again, size) != 0) {
+                            printf("FAIL %s: differs from a full pass over the same frame\n", name);
+                            describe_drift(out, again, size, fmt, img->width);
+                            run.cases++;
+                            run.failures++;
+                            continue;
+                        }
+                        if (!golden_case(&run, name, out, again, size, fmt, mode, img->width)) return 1;
+                    }
+                }
+            }
+        }
+    }
+    const size_t cases = run.cases, failures = run.failures;
+
+    size_t plan_cases = 0;
+    const size_t plan_failures = check_plan(images, image_count, out, again, &plan_cases);
+    printf("stage plan: %zu cases, %zu changed the output\n", plan_cases, plan_failures);
+
+    if (generate) {
+        printf("%zu goldens written to %s, %zu cases failed\n", cases - failures, dir, failures);
+    } else {
+        printf("%zu cases, %zu passed, %zu failed\n", cases, cases - failures, failures);
+    }
+
+    for (size_t i = 0; i < image_count; i++)
+        free(images[i].rgbx8);
+    free(out);
+    free(again);
+    free(expected);
+    return failures || plan_failures ? 1 : 0;
+}
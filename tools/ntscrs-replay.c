@@ -0,0 +1,176 @@
+/*
+ntsc-rs-obs
+Copyright (C) 2025 eigenpunk
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along
+with this program. If not, see <https://www.gnu.org/licenses/>
+*/
+
+// Replays a trace captured by the filter through ntscrs_apply_effect_to_buffer
+// as fast as possible and reports per-frame timings. With -d the draft path is
+// timed instead, and each draft frame is compared against the full-quality
+// output to report the PSNR cost of draft mode.
+
+#include <inttypes.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "tool-common.h"
+#include "trace.h"
+
+static int compare_u64(const void *a, const void *b) {
+    const uint64_t x = *(const uint64_t *)a, y = *(const uint64_t *)b;
+    return (x > y) - (x < y);
+}
+
+static void usage(const char *argv0) {
+    fprintf(stderr, "usage: %s [-d] [-n loops] [-w warmup_frames] <trace>\n", argv0);
+}
+
+int main(int argc, char **argv) {
+    long loops = 1, warmup = 0;
+    bool draft = false;
+    const char *path = NULL;
+
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "-n") && i + 1 < argc) {
+            loops = strtol(argv[++i], NULL, 10);
+        } else if (!strcmp(argv[i], "-d")) {
+            draft = true;
+        } else if (!strcmp(argv[i], "-w") && i + 1 < argc) {
+            warmup = strtol(argv[++i], NULL, 10);
+        } else if (argv[i][0] != '-' && !path) {
+            path = argv[i];
+        } else {
+            usage(argv[0]);
+            return 2;
+        }
+    }
+    if (!path || loops < 1 || warmup < 0) {
+        usage(argv[0]);
+        return 2;
+    }
+
+    struct ntscrs_trace trace;
+    if (!ntscrs_trace_open(&trace, path)) {
+        fprintf(stderr, "%s: not a readable trace (or recorded with a different ntscrs.h)\n", path);
+        return 1;
+    }
+
+    const struct ntscrs_trace_header *h = trace.header;
+    const size_t frame_size = (size_t)h->width * h->height * h->bytes_per_pixel;
+    if (h->frame_count == 0 || frame_size == 0) {
+        fprintf(stderr, "%s: trace is empty\n", path);
+        ntscrs_trace_close(&trace);
+        return 1;
+    }
+
+    const bool is_8bit = h->pix_fmt == Rgbx8 || h->pix_fmt == Xrgb8 || h->pix_fmt == Bgrx8 || h->pix_fmt == Xbgr8;
+    if (draft && !is_8bit) {
+        fprintf(stderr, "draft mode only differs for 8-bit 4-channel traces; timing full quality\n");
+        draft = false;
+    }
+
+    uint8_t *work = malloc(frame_size);
+    uint8_t *reference = draft ? malloc(frame_size) : NULL;
+    uint8_t *scratch = (h->flags & NTSCRS_TRACE_LZ4) ? malloc(frame_size) : NULL;
+    const size_t samples = (size_t)h->frame_count * (size_t)loops;
+    uint64_t *times = malloc(samples * sizeof(*times));
+    if (!work || !times || ((h->flags & NTSCRS_TRACE_LZ4) && !scratch) || (draft && !reference)) {
+        fprintf(stderr, "out of memory\n");
+        return 1;
+    }
+
+    printf("%s: %" PRIu64 " frames, %ux%u, pixel format %u%s%s\n", path, h->frame_count, h->width, h->height,
+           h->pix_fmt, (h->flags & NTSCRS_TRACE_LZ4) ? ", lz4" : "", draft ? ", draft" : "");
+
+    double psnr_sum = 0.0, psnr_min = INFINITY;
+    size_t psnr_n = 0;
+    size_t n = 0;
+    for (long loop = 0; loop < loops; loop++) {
+        for (uint64_t i = 0; i < h->frame_count; i++) {
+            const struct ntscrs_trace_record *r;
+            const uint8_t *pixels = ntscrs_trace_frame(&trace, i, &r, scratch, frame_size);
+            if (!pixels || r->raw_size != frame_size) {
+                fprintf(stderr, "frame %" PRIu64 ": corrupt or unsupported record\n", i);
+                return 1;
+            }
+
+            // the effect works in place, so every pass starts from a fresh copy
+            memcpy(work, pixels, frame_size);
+
+            const uint64_t start = tool_now_ns();
+            if (draft) {
+                ntscrs_apply_effect_to_buffer_draft(r->params, h->width, h->height, work,
+                                                    (NtscRsPixelFormat)h->pix_fmt, (size_t)r->frame_num);
+            } else {
+                ntscrs_apply_effect_to_buffer(r->params, h->width, h->height, work, (NtscRsPixelFormat)h->pix_fmt,
+                                              (size_t)r->frame_num);
+            }
+            const uint64_t elapsed = tool_now_ns() - start;
+
+            // quality only needs measuring once per frame
+            if (draft && loop == 0) {
+                memcpy(reference, pixels, frame_size);
+                ntscrs_apply_effect_to_buffer(r->params, h->width, h->height, reference,
+                                              (NtscRsPixelFormat)h->pix_fmt, (size_t)r->frame_num);
+                const double psnr = tool_psnr(work, reference, frame_size, (NtscRsPixelFormat)h->pix_fmt);
+                if (isfinite(psnr)) {
+                    psnr_sum += psnr;
+                    psnr_n++;
+                }
+                if (psnr < psnr_min) psnr_min = psnr;
+            }
+
+            if (warmup > 0) {
+                warmup--;
+            } else {
+                times[n++] = elapsed;
+            }
+        }
+    }
+
+    if (n == 0) {
+        fprintf(stderr, "no frames left after warmup\n");
+        return 1;
+    }
+
+    uint64_t total = 0;
+    for (size_t i = 0; i < n; i++)
+        total += times[i];
+    qsort(times, n, sizeof(*times), compare_u64);
+
+    const double mean_ms = (double)total / (double)n / 1e6;
+    const double mpix = (double)h->width * h->height / 1e6;
+    printf("frames:  %zu\n", n);
+    printf("mean:    %.3f ms\n", mean_ms);
+    printf("min:     %.3f ms\n", (double)times[0] / 1e6);
+    printf("p50:     %.3f ms\n", (double)times[n / 2] / 1e6);
+    printf("p99:     %.3f ms\n", (double)times[(n * 99) / 100] / 1e6);
+    printf("max:     %.3f ms\n", (double)times[n - 1] / 1e6);
+    printf("rate:    %.1f fps, %.1f Mpix/s\n", 1e3 / mean_ms, mpix * 1e3 / mean_ms);
+    if (draft) {
+        // frames identical to the reference are left out of the mean
+        printf("psnr:    mean %.2f dB, min %.2f dB vs full quality\n", psnr_n ? psnr_sum / (double)psnr_n : INFINITY,
+               psnr_min);
+    }
+
+    free(reference);
+    free(times);
+    free(scratch);
+    free(work);
+    ntscrs_trace_close(&trace);
+    return 0;
+}
@@ -0,0 +1,210 @@
+/*
+ntsc-rs-obs
+Copyright (C) 2025 eigenpunk
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along
+with this program. If not, see <https://www.gnu.org/licenses/>
+*/
+
+// Reads the frames a filter publishes to shared memory (see shm-ring.h) the
+// way an external recorder would and reports the throughput it gets: frames
+// and bytes per second, frames lost to the writer lapping the reader or torn
+// while being read, and how long after publishing frames were read. Frames
+// are read in place from the mapping; with -c they are copied out first, as a
+// consumer that keeps them would.
+
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifndef _WIN32
+#include <time.h>
+#endif
+
+#include "tool-common.h"
+#include "shm-ring.h"
+
+#define REPORT_INTERVAL_NS 1000000000ull
+
+struct window {
+    uint64_t frames;
+    uint64_t bytes;
+    uint64_t missed;
+    uint64_t torn;
+    uint64_t latency_sum_ns;
+    uint64_t latency_max_ns;
+};
+
+static void usage(const char *argv0) {
+    fprintf(stderr, "usage: %s [-c] [-t seconds] <name>\n", argv0);
+}
+
+static void sleep_ms(unsigned ms) {
+#ifdef _WIN32
+    Sleep(ms);
+#else
+    const struct timespec ts = {.tv_sec = ms / 1000, .tv_nsec = (long)(ms % 1000) * 1000000};
+    nanosleep(&ts, NULL);
+#endif
+}
+
+// reads every byte of the frame, so in-place reads cost what a real consumer's would
+static uint64_t checksum(const uint8_t *data, size_t size) {
+    uint64_t sum = 0;
+    for (size_t i = 0; i + 8 <= size; i += 8) {
+        uint64_t v;
+        memcpy(&v, data + i, 8);
+        sum += v;
+    }
+    return sum;
+}
+
+static void report(const char *label, const struct window *w, uint64_t ns) {
+    const double s = (double)ns / 1e9;
+    printf("%s%.1f fps, %.1f MiB/s, %" PRIu64 " missed, %" PRIu64 " torn, latency mean %.2f ms, max %.2f ms\n", label,
+           (double)w->frames / s, (double)w->bytes / s / (1024.0 * 1024.0), w->missed, w->torn,
+           w->frames ? (double)w->latency_sum_ns / (double)w->frames / 1e6 : 0.0, (double)w->latency_max_ns / 1e6);
+}
+
+static bool open_ring(struct ntscrs_shm_reader *r, const char *name, uint64_t until) {
+    bool waiting = false;
+    while (!ntscrs_shm_open(r, name)) {
+        if (tool_now_ns() >= until) return false;
+        if (!waiting) {
+            fprintf(stderr, "waiting for '%s'...\n", name);
+            waiting = true;
+        }
+        sleep_ms(100);
+    }
+    const struct ntscrs_shm_header *h = r->header;
+    printf("%s: %ux%u, pixel format %u, %u slots\n", name, h->width, h->height, h->pix_fmt, h->slot_count);
+    return true;
+}
+
+int main(int argc, char **argv) {
+    bool copy = false;
+    long seconds = 10;
+    const char *name = NULL;
+
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "-c")) {
+            copy = true;
+        } else if (!strcmp(argv[i], "-t") && i + 1 < argc) {
+            seconds = strtol(argv[++i], NULL, 10);
+        } else if (argv[i][0] != '-' && !name) {
+            name = argv[i];
+        } else {
+            usage(argv[0]);
+            return 2;
+        }
+    }
+    if (!name || seconds < 1) {
+        usage(argv[0]);
+        return 2;
+    }
+
+    const uint64_t start = tool_now_ns();
+    const uint64_t until = start + (uint64_t)seconds * 1000000000ull;
+    struct ntscrs_shm_reader ring;
+    if (!open_ring(&ring, name, until)) {
+        fprintf(stderr, "%s: no ring of that name showed up\n", name);
+        return 1;
+    }
+
+    uint8_t *copied = NULL;
+    size_t copied_size = 0;
+    uint64_t next = ntscrs_shm_published(&ring) + 1;
+    struct window window = {0}, total = {0};
+    uint64_t window_start = tool_now_ns();
+    volatile uint64_t sink = 0;
+
+    for (uint64_t now = window_start; now < until; now = tool_now_ns()) {
+        if (now - window_start >= REPORT_INTERVAL_NS) {
+            report("  ", &window, now - window_start);
+            total.missed += window.missed;
+            total.torn += window.torn;
+            window = (struct window){0};
+            window_start = now;
+        }
+
+        if (ntscrs_shm_closed(&ring)) {
+            ntscrs_shm_close(&ring);
+            if (!open_ring(&ring, name, until)) break;
+            next = ntscrs_shm_published(&ring) + 1;
+            continue;
+        }
+
+        const uint64_t published = ntscrs_shm_published(&ring);
+        if (published < next) {
+            sleep_ms(1);
+            continue;
+        }
+
+        // the oldest frames may be gone already
+        const uint32_t slots = ring.header->slot_count;
+        if (published - next >= slots) {
+            window.missed += published - slots + 1 - next;
+            next = published - slots + 1;
+        }
+
+        const struct ntscrs_shm_header *h = ring.header;
+        const size_t size = (size_t)h->linesize * h->height;
+        const struct ntscrs_shm_slot *slot;
+        uint64_t seq;
+        const uint8_t *pixels = ntscrs_shm_frame(&ring, next, &slot, &seq);
+        next++;
+        if (!pixels) {
+            window.missed++;
+            continue;
+        }
+
+        const uint64_t published_ns = slot->timestamp_ns;
+        if (copy) {
+            if (copied_size < size) {
+                free(copied);
+                copied = malloc(size);
+                copied_size = copied ? size : 0;
+                if (!copied) {
+                    fprintf(stderr, "out of memory\n");
+                    return 1;
+                }
+            }
+            memcpy(copied, pixels, size);
+        } else {
+            sink += checksum(pixels, size);
+        }
+        if (!ntscrs_shm_frame_valid(slot, seq)) {
+            window.torn++;
+            continue;
+        }
+
+        const uint64_t latency = tool_now_ns() - published_ns;
+        window.frames++;
+        window.bytes += size;
+        window.latency_sum_ns += latency;
+        if (latency > window.latency_max_ns) window.latency_max_ns = latency;
+
+        total.frames++;
+        total.bytes += size;
+        total.latency_sum_ns += latency;
+        if (latency > total.latency_max_ns) total.latency_max_ns = latency;
+    }
+    total.missed += window.missed;
+    total.torn += window.torn;
+
+    report(copy ? "total (copying): " : "total (in place): ", &total, tool_now_ns() - start);
+    ntscrs_shm_close(&ring);
+    free(copied);
+    return 0;
+}
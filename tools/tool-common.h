@@ -0,0 +1,70 @@
+/*
+ntsc-rs-obs
+Copyright (C) 2025 eigenpunk
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along
+with this program. If not, see <https://www.gnu.org/licenses/>
+*/
+
+#pragma once
+
+#include <math.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include <ntscrs.h>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <time.h>
+#endif
+
+static inline uint64_t tool_now_ns(void) {
+#ifdef _WIN32
+    LARGE_INTEGER freq, count;
+    QueryPerformanceFrequency(&freq);
+    QueryPerformanceCounter(&count);
+    return (uint64_t)((double)count.QuadPart * 1e9 / (double)freq.QuadPart);
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+#endif
+}
+
+static inline bool tool_pix_fmt_is_16bit(NtscRsPixelFormat pix_fmt) {
+    return pix_fmt == Rgbx16 || pix_fmt == Xrgb16 || pix_fmt == Bgrx16 || pix_fmt == Xbgr16;
+}
+
+// PSNR over the color channels of a 4-channel 8- or 16-bit unsigned frame,
+// skipping padding
+static inline double tool_psnr(const uint8_t *a, const uint8_t *b, size_t size, NtscRsPixelFormat pix_fmt) {
+    const bool wide = tool_pix_fmt_is_16bit(pix_fmt);
+    const size_t pad = (pix_fmt == Xrgb8 || pix_fmt == Xbgr8 || pix_fmt == Xrgb16 || pix_fmt == Xbgr16) ? 0 : 3;
+    const size_t samples = wide ? size / 2 : size;
+    const double peak = wide ? 65535.0 : 255.0;
+    double sse = 0.0;
+    size_t n = 0;
+    for (size_t i = 0; i < samples; i++) {
+        if (i % 4 == pad) continue;
+        const double d = wide ? (double)((const uint16_t *)a)[i] - (double)((const uint16_t *)b)[i]
+                              : (double)a[i] - (double)b[i];
+        sse += d * d;
+        n++;
+    }
+    if (sse == 0.0) return INFINITY;
+    return 10.0 * log10(peak * peak / (sse / (double)n));
+}